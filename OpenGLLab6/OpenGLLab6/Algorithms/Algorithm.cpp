@@ -1,5 +1,7 @@
 ﻿#define _USE_MATH_DEFINES
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <string>
 
 #include "../Algorithms.h"
@@ -7,6 +9,11 @@
 
 namespace Algorithms
 {
+    ClipWindow ClipWindow::unbounded()
+    {
+        return ClipWindow{std::numeric_limits<int>::min(), std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
+    }
+
     Algorithm::Algorithm(const std::string &name, const Callback& setPixel) : _setPixel(setPixel), _name(name)
     {
     }
@@ -16,6 +23,55 @@ namespace Algorithms
         return this->_name;
     }
 
+    void Algorithm::apply(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint) const
+    {
+        this->apply(startPoint, endPoint, ClipWindow::unbounded());
+    }
+
+    bool Algorithm::clipSteps(int steps, int majorStart, int majorDirection, int majorMin, int majorMax,
+                              double minorStart, double minorSlope, int minorMin, int minorMax, int& first, int& last) const
+    {
+        // 以 long long 計算，不限制範圍時才不會溢位
+        long long firstStep = 0;
+        long long lastStep = steps;
+        if (majorDirection > 0)
+        {
+            firstStep = std::max(firstStep, static_cast<long long>(majorMin) - majorStart);
+            lastStep = std::min(lastStep, static_cast<long long>(majorMax) - majorStart);
+        }
+        else
+        {
+            firstStep = std::max(firstStep, static_cast<long long>(majorStart) - majorMax);
+            lastStep = std::min(lastStep, static_cast<long long>(majorStart) - majorMin);
+        }
+
+        // 副軸多留兩格，涵蓋四捨五入、浮點誤差與反鋸齒多畫的格子
+        const double lower = static_cast<double>(minorMin) - 2.0 - minorStart;
+        const double upper = static_cast<double>(minorMax) + 2.0 - minorStart;
+        if (minorSlope == 0.0)
+        {
+            if (lower > 0.0 || upper < 0.0)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            const double from = std::min(lower / minorSlope, upper / minorSlope);
+            const double to = std::max(lower / minorSlope, upper / minorSlope);
+            firstStep = std::max(firstStep, static_cast<long long>(std::ceil(std::min(std::max(from, 0.0), static_cast<double>(steps) + 1.0))));
+            lastStep = std::min(lastStep, static_cast<long long>(std::floor(std::min(std::max(to, -1.0), static_cast<double>(steps)))));
+        }
+
+        if (firstStep > lastStep)
+        {
+            return false;
+        }
+        first = static_cast<int>(firstStep);
+        last = static_cast<int>(lastStep);
+        return true;
+    }
+
     void Algorithm::sortPoints(std::pair<int, int>& startPoint, std::pair<int, int>& endPoint) const
     {
         if (startPoint.first > endPoint.first || (startPoint.first == endPoint.first && startPoint.second > endPoint.second))
@@ -1,4 +1,4 @@
-#define _USE_MATH_DEFINES
+﻿#define _USE_MATH_DEFINES
 #include <iostream>
 #include <cmath>
 #include <climits>
@@ -12,81 +12,104 @@ namespace Algorithms
     {
     }
 
-    void AntiAliasingAlgorithm::rasterizeLineInPositiveSlope(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint, const int& dx, const int& dy, const bool& isSlopeBiggerThanOne) const
+    bool AntiAliasingAlgorithm::isAntiAliased() const
     {
-        const double slope = static_cast<double>(dy) / static_cast<double>(dx);
+        return true;
+    }
 
-        double x = startPoint.first;
-        double y = startPoint.second;
+    void AntiAliasingAlgorithm::rasterizeLineInPositiveSlope(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint, const int& dx, const int& dy, const bool& isSlopeBiggerThanOne, const ClipWindow& clip) const
+    {
+        const double slope = static_cast<double>(dy) / static_cast<double>(dx);
+        int first;
+        int last;
 
+        // 每一步都由起點直接計算位置，只畫 clip 內的部分時結果也相同
         if (isSlopeBiggerThanOne)
         {
-            while (y <= endPoint.second)
+            const double step = dx != 0 ? 1.0 / slope : 0.0;
+            if (!this->clipSteps(endPoint.second - startPoint.second, startPoint.second, 1, clip.bottom, clip.top, startPoint.first, step, clip.left, clip.right, first, last))
             {
+                return;
+            }
+
+            for (int i = first; i <= last; i++)
+            {
+                const double&& x = startPoint.first + i * step;
+                const double&& y = startPoint.second + i;
                 const double&& xi = static_cast<int>(std::floor(x));
                 const double&& alpha = x - xi;
 
                 this->_setPixel(xi, y, 1.0 - alpha);
                 this->_setPixel(xi + 1.0, y, alpha);
-
-                x += 1.0 / slope;
-                y++;
             }
         }
         else
         {
-            while (x <= endPoint.first)
+            if (!this->clipSteps(endPoint.first - startPoint.first, startPoint.first, 1, clip.left, clip.right, startPoint.second, slope, clip.bottom, clip.top, first, last))
+            {
+                return;
+            }
+
+            for (int i = first; i <= last; i++)
             {
+                const double&& x = startPoint.first + i;
+                const double&& y = startPoint.second + i * slope;
                 const double&& yi = static_cast<int>(std::floor(y));
                 const double&& alpha = y - yi;
 
                 this->_setPixel(x, yi, 1.0 - alpha);
                 this->_setPixel(x, yi + 1.0, alpha);
-
-                y += slope;
-                x++;
             }
         }
     }
 
-    void AntiAliasingAlgorithm::rasterizeLineInNegativeSlope(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint, const int& dx, const int& dy, const bool& isSlopeBiggerThanOne) const
+    void AntiAliasingAlgorithm::rasterizeLineInNegativeSlope(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint, const int& dx, const int& dy, const bool& isSlopeBiggerThanOne, const ClipWindow& clip) const
     {
         const double slope = static_cast<double>(dy) / static_cast<double>(dx);
+        int first;
+        int last;
 
-        double x = startPoint.first;
-        double y = startPoint.second;
-
+        // 每一步都由起點直接計算位置，只畫 clip 內的部分時結果也相同
         if (isSlopeBiggerThanOne)
         {
-            while (y >= endPoint.second)
+            const double step = -1.0 / slope;
+            if (!this->clipSteps(startPoint.second - endPoint.second, startPoint.second, -1, clip.bottom, clip.top, startPoint.first, step, clip.left, clip.right, first, last))
+            {
+                return;
+            }
+
+            for (int i = first; i <= last; i++)
             {
+                const double&& x = startPoint.first + i * step;
+                const double&& y = startPoint.second - i;
                 const double&& xi = static_cast<int>(std::floor(x));
                 const double&& alpha = x - xi;
 
                 this->_setPixel(xi, y, 1.0 - alpha);
                 this->_setPixel(xi + 1.0, y, alpha);
-
-                x -= 1.0 / slope;
-                y--;
             }
         }
         else
         {
-            while (x <= endPoint.first)
+            if (!this->clipSteps(endPoint.first - startPoint.first, startPoint.first, 1, clip.left, clip.right, startPoint.second, slope, clip.bottom, clip.top, first, last))
             {
+                return;
+            }
+
+            for (int i = first; i <= last; i++)
+            {
+                const double&& x = startPoint.first + i;
+                const double&& y = startPoint.second + i * slope;
                 const double&& yi = static_cast<int>(std::floor(y));
                 const double&& alpha = y - yi;
 
                 this->_setPixel(x, yi, 1.0 - alpha);
                 this->_setPixel(x, yi + 1.0, alpha);
-
-                y += slope;
-                x++;
             }
         }
     }
 
-    void AntiAliasingAlgorithm::apply(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint) const
+    void AntiAliasingAlgorithm::apply(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint, const ClipWindow& clip) const
     {
         std::pair<int, int> _startPoint = startPoint;
         std::pair<int, int> _endPoint = endPoint;
@@ -99,11 +122,11 @@ namespace Algorithms
 
         if (isSlopeNegative)
         {
-            this->rasterizeLineInNegativeSlope(_startPoint, _endPoint, dx, dy, slope);
+            this->rasterizeLineInNegativeSlope(_startPoint, _endPoint, dx, dy, slope, clip);
         }
         else
         {
-            this->rasterizeLineInPositiveSlope(_startPoint, _endPoint, dx, dy, slope);
+            this->rasterizeLineInPositiveSlope(_startPoint, _endPoint, dx, dy, slope, clip);
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+﻿#include <string>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#include "../Algorithms.h"
+
+namespace Algorithms
+{
+    CpuFeatures CpuFeatures::detect()
+    {
+        CpuFeatures features{false, false, false};
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        features.hasSse2 = (info[3] & (1 << 26)) != 0;
+        // AVX2 還需要作業系統會保存 YMM 暫存器
+        const bool hasOsSavedYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+        if (maxLeaf >= 7 && hasOsSavedYmm)
+        {
+            __cpuidex(info, 7, 0);
+            features.hasAvx2 = (info[1] & (1 << 5)) != 0;
+        }
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        features.hasSse2 = __builtin_cpu_supports("sse2");
+        features.hasAvx2 = __builtin_cpu_supports("avx2");
+#elif defined(__aarch64__) || defined(_M_ARM64)
+        features.hasNeon = true;
+#endif
+
+        return features;
+    }
+
+    bool CpuFeatures::supports(InstructionSet instructionSet) const
+    {
+        switch (instructionSet)
+        {
+        case InstructionSet::Sse2:
+            return this->hasSse2;
+        case InstructionSet::Avx2:
+            return this->hasAvx2;
+        case InstructionSet::Neon:
+            return this->hasNeon;
+        case InstructionSet::Generic:
+        default:
+            return true;
+        }
+    }
+
+    std::string CpuFeatures::toString() const
+    {
+        std::string result = "generic";
+        if (this->hasSse2)
+        {
+            result += " sse2";
+        }
+        if (this->hasAvx2)
+        {
+            result += " avx2";
+        }
+        if (this->hasNeon)
+        {
+            result += " neon";
+        }
+        return result;
+    }
+}
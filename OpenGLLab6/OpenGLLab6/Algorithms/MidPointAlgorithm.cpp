@@ -1,4 +1,4 @@
-#define _USE_MATH_DEFINES
+﻿#define _USE_MATH_DEFINES
 #include <iostream>
 #include <cmath>
 #include <climits>
@@ -10,11 +10,51 @@
 
 namespace Algorithms
 {
+    namespace
+    {
+        // b 需大於 0
+        long long floorDivide(long long a, long long b)
+        {
+            return a >= 0 ? a / b : -((-a + b - 1) / b);
+        }
+
+        // 不畫格子直接前進 steps 步，更新中點判斷值 d 並回傳副軸前進的步數；
+        // 每步 d 加上 delE，副軸前進時改加 delNE，isMinorWhenPositive 表示 d > 0 時副軸前進，否則為 d <= 0 時
+        int skipSteps(int& d, int delE, int delNE, bool isMinorWhenPositive, int steps)
+        {
+            if (steps == 0)
+            {
+                return 0;
+            }
+
+            // d 會一直落在寬度為 |delNE - delE| 的區間內，因此可以直接算出副軸前進的步數
+            const long long increment = delE;
+            const long long minorIncrement = static_cast<long long>(delNE) - delE;
+            long long minorSteps;
+            if (isMinorWhenPositive)
+            {
+                minorSteps = -floorDivide(-(d + (steps - 1) * increment), -minorIncrement);
+            }
+            else
+            {
+                minorSteps = floorDivide((1 - steps) * increment - d, minorIncrement) + 1;
+            }
+
+            d = static_cast<int>(d + steps * increment + minorSteps * minorIncrement);
+            return static_cast<int>(minorSteps);
+        }
+    }
+
     MidPointAlgorithm::MidPointAlgorithm(const Callback& setPixel) : Algorithm("midpoint", setPixel)
     {
     }
 
-    void MidPointAlgorithm::rasterizeLineInPositiveSlope(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint, const int& dx, const int& dy, const bool& isSlopeBiggerThanOne) const
+    bool MidPointAlgorithm::isAntiAliased() const
+    {
+        return false;
+    }
+
+    void MidPointAlgorithm::rasterizeLineInPositiveSlope(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint, const int& dx, const int& dy, const bool& isSlopeBiggerThanOne, const ClipWindow& clip) const
     {
         const double alpha = 1.0;
 
@@ -35,11 +75,21 @@ namespace Algorithms
 
         int x = startPoint.first;
         int y = startPoint.second;
-        this->_setPixel(x, y, alpha);
+        int first;
+        int last;
 
         if (isSlopeBiggerThanOne)
         {
-            while (y < endPoint.second)
+            // 從進入 clip 的那一步開始畫，離開後就停止
+            if (!this->clipSteps(endPoint.second - y, y, 1, clip.bottom, clip.top, x, dy != 0 ? static_cast<double>(dx) / dy : 0.0, clip.left, clip.right, first, last))
+            {
+                return;
+            }
+            x += skipSteps(d, delE, delNE, false, first);
+            y += first;
+            this->_setPixel(x, y, alpha);
+
+            for (int step = first; step < last; step++)
             {
                 if (d > 0)
                 {
@@ -56,7 +106,15 @@ namespace Algorithms
         }
         else
         {
-            while (x < endPoint.first)
+            if (!this->clipSteps(endPoint.first - x, x, 1, clip.left, clip.right, y, static_cast<double>(dy) / dx, clip.bottom, clip.top, first, last))
+            {
+                return;
+            }
+            y += skipSteps(d, delE, delNE, true, first);
+            x += first;
+            this->_setPixel(x, y, alpha);
+
+            for (int step = first; step < last; step++)
             {
                 if (d <= 0)
                 {
@@ -73,7 +131,7 @@ namespace Algorithms
         }
     }
 
-    void MidPointAlgorithm::rasterizeLineInNegativeSlope(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint, const int& dx, const int& dy, const bool& isSlopeBiggerThanOne) const
+    void MidPointAlgorithm::rasterizeLineInNegativeSlope(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint, const int& dx, const int& dy, const bool& isSlopeBiggerThanOne, const ClipWindow& clip) const
     {
         const double alpha = 1.0;
 
@@ -94,11 +152,21 @@ namespace Algorithms
 
         int x = startPoint.first;
         int y = startPoint.second;
-        this->_setPixel(x, y, alpha);
+        int first;
+        int last;
 
         if (isSlopeBiggerThanOne)
         {
-            while (y > endPoint.second)
+            // 從進入 clip 的那一步開始畫，離開後就停止
+            if (!this->clipSteps(y - endPoint.second, y, -1, clip.bottom, clip.top, x, static_cast<double>(dx) / -dy, clip.left, clip.right, first, last))
+            {
+                return;
+            }
+            x += skipSteps(d, delE, delNE, true, first);
+            y -= first;
+            this->_setPixel(x, y, alpha);
+
+            for (int step = first; step < last; step++)
             {
                 if (d <= 0)
                 {
@@ -115,7 +183,15 @@ namespace Algorithms
         }
         else
         {
-            while (x < endPoint.first)
+            if (!this->clipSteps(endPoint.first - x, x, 1, clip.left, clip.right, y, static_cast<double>(dy) / dx, clip.bottom, clip.top, first, last))
+            {
+                return;
+            }
+            y -= skipSteps(d, delE, delNE, false, first);
+            x += first;
+            this->_setPixel(x, y, alpha);
+
+            for (int step = first; step < last; step++)
             {
                 if (d > 0)
                 {
@@ -132,7 +208,7 @@ namespace Algorithms
         }
     }
 
-    void MidPointAlgorithm::apply(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint) const
+    void MidPointAlgorithm::apply(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint, const ClipWindow& clip) const
     {
         std::pair<int, int> _startPoint = startPoint;
         std::pair<int, int> _endPoint = endPoint;
@@ -145,11 +221,11 @@ namespace Algorithms
 
         if (isSlopeNegative)
         {
-            this->rasterizeLineInNegativeSlope(_startPoint, _endPoint, dx, dy, slope);
+            this->rasterizeLineInNegativeSlope(_startPoint, _endPoint, dx, dy, slope, clip);
         }
         else
         {
-            this->rasterizeLineInPositiveSlope(_startPoint, _endPoint, dx, dy, slope);
+            this->rasterizeLineInPositiveSlope(_startPoint, _endPoint, dx, dy, slope, clip);
         }
     }
 }
\ No newline at end of file
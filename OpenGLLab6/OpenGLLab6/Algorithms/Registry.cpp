@@ -0,0 +1,145 @@
+﻿#include <cmath>
+#include <string>
+#include <vector>
+
+#include "../Algorithms.h"
+
+namespace Algorithms
+{
+    namespace
+    {
+        // 指令集越新越優先
+        int getInstructionSetRank(InstructionSet instructionSet)
+        {
+            switch (instructionSet)
+            {
+            case InstructionSet::Avx2:
+                return 2;
+            case InstructionSet::Sse2:
+            case InstructionSet::Neon:
+                return 1;
+            case InstructionSet::Generic:
+            default:
+                return 0;
+            }
+        }
+    }
+
+    BatchStatistics BatchStatistics::measure(const std::vector<Segment>& segments)
+    {
+        BatchStatistics statistics{segments.size(), 0.0, 0.0};
+        if (segments.empty())
+        {
+            return statistics;
+        }
+
+        size_t steepCount = 0;
+        double totalLength = 0.0;
+        for (const Segment& segment : segments)
+        {
+            const int dx = std::abs(segment.second.first - segment.first.first);
+            const int dy = std::abs(segment.second.second - segment.first.second);
+            totalLength += std::hypot(dx, dy);
+            if (dy > dx)
+            {
+                steepCount++;
+            }
+        }
+
+        statistics.meanLength = totalLength / segments.size();
+        statistics.steepRatio = static_cast<double>(steepCount) / segments.size();
+        return statistics;
+    }
+
+    Registry::Registry(const CpuFeatures& features) : _features(features)
+    {
+    }
+
+    void Registry::add(const Capabilities& capabilities, const Factory& factory)
+    {
+        const std::unique_ptr<Algorithm> sample = factory([](double, double, double) {});
+        this->_entries.push_back(Entry{sample->getName(), sample->isAntiAliased(), capabilities, factory});
+    }
+
+    size_t Registry::size() const
+    {
+        return this->_entries.size();
+    }
+
+    const CpuFeatures& Registry::getFeatures() const
+    {
+        return this->_features;
+    }
+
+    const std::string& Registry::getName(size_t index) const
+    {
+        return this->_entries[index].name;
+    }
+
+    bool Registry::isAntiAliased(size_t index) const
+    {
+        return this->_entries[index].isAntiAliased;
+    }
+
+    const Capabilities& Registry::getCapabilities(size_t index) const
+    {
+        return this->_entries[index].capabilities;
+    }
+
+    bool Registry::isSupported(size_t index) const
+    {
+        return this->_features.supports(this->_entries[index].capabilities.instructionSet);
+    }
+
+    bool Registry::find(const std::string& name, size_t& index) const
+    {
+        for (size_t i = 0; i < this->_entries.size(); i++)
+        {
+            if (this->_entries[i].name == name)
+            {
+                index = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool Registry::select(bool isAntiAliased, const std::vector<Segment>& segments, size_t& index) const
+    {
+        const BatchStatistics statistics = BatchStatistics::measure(segments);
+
+        // 長度在適合範圍內最重要，其次是斜率，最後才比較指令集；同分時取先註冊的
+        int bestScore = -1;
+        for (size_t i = 0; i < this->_entries.size(); i++)
+        {
+            const Entry& entry = this->_entries[i];
+            if (entry.isAntiAliased != isAntiAliased || !this->isSupported(i))
+            {
+                continue;
+            }
+
+            const Capabilities& capabilities = entry.capabilities;
+            const bool isLengthPreferred = statistics.meanLength >= capabilities.minPreferredLength && statistics.meanLength <= capabilities.maxPreferredLength;
+            const bool isSlopePreferred = capabilities.slopePreference == SlopePreference::Any ||
+                                          (capabilities.slopePreference == SlopePreference::Steep) == (statistics.steepRatio > 0.5);
+
+            const int score = (isLengthPreferred ? 8 : 0) + (isSlopePreferred ? 4 : 0) + getInstructionSetRank(capabilities.instructionSet);
+            if (score > bestScore)
+            {
+                index = i;
+                bestScore = score;
+            }
+        }
+        return bestScore >= 0;
+    }
+
+    std::vector<std::unique_ptr<Algorithm>> Registry::createAll(const Callback& setPixel) const
+    {
+        std::vector<std::unique_ptr<Algorithm>> algorithms;
+        for (const Entry& entry : this->_entries)
+        {
+            algorithms.push_back(entry.factory(setPixel));
+        }
+        return algorithms;
+    }
+}
@@ -0,0 +1,292 @@
+﻿#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "../rendering.h"
+
+namespace Rendering
+{
+    namespace
+    {
+        constexpr int WORD_BITS = 64;
+        constexpr uint64_t ALL_BITS = ~static_cast<uint64_t>(0);
+
+        // 被設定的 bit 數
+        int countBits(uint64_t word)
+        {
+#if defined(_MSC_VER) && defined(_M_X64)
+            return static_cast<int>(__popcnt64(word));
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+            return static_cast<int>(_CountOneBits64(word));
+#elif defined(_MSC_VER)
+            // 32 bit 平台沒有 64 bit 版本，分成高低兩半
+            return static_cast<int>(__popcnt(static_cast<unsigned int>(word)) + __popcnt(static_cast<unsigned int>(word >> 32)));
+#else
+            return __builtin_popcountll(word);
+#endif
+        }
+
+        // 最低位被設定的 bit，word 不可為 0
+        int findLowestBit(uint64_t word)
+        {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+            unsigned long index;
+            _BitScanForward64(&index, word);
+            return static_cast<int>(index);
+#elif defined(_MSC_VER)
+            // 32 bit 平台沒有 64 bit 版本，先找低半部再找高半部
+            unsigned long index;
+            if (_BitScanForward(&index, static_cast<unsigned long>(word)))
+            {
+                return static_cast<int>(index);
+            }
+            _BitScanForward(&index, static_cast<unsigned long>(word >> 32));
+            return static_cast<int>(index) + 32;
+#else
+            return __builtin_ctzll(word);
+#endif
+        }
+
+        // 最高位被設定的 bit，word 不可為 0
+        int findHighestBit(uint64_t word)
+        {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+            unsigned long index;
+            _BitScanReverse64(&index, word);
+            return static_cast<int>(index);
+#elif defined(_MSC_VER)
+            // 32 bit 平台沒有 64 bit 版本，先找高半部再找低半部
+            unsigned long index;
+            if (_BitScanReverse(&index, static_cast<unsigned long>(word >> 32)))
+            {
+                return static_cast<int>(index) + 32;
+            }
+            _BitScanReverse(&index, static_cast<unsigned long>(word));
+            return static_cast<int>(index);
+#else
+            return WORD_BITS - 1 - __builtin_clzll(word);
+#endif
+        }
+
+        // 以遮罩走訪一列中 [first, last] 欄所在的每個 word
+        template <typename Word, typename Operation>
+        void forEachMaskedWord(Word* row, int first, int last, Operation apply)
+        {
+            const uint64_t firstMask = ALL_BITS << (first % WORD_BITS);
+            const uint64_t lastMask = ALL_BITS >> (WORD_BITS - 1 - last % WORD_BITS);
+
+            if (first / WORD_BITS == last / WORD_BITS)
+            {
+                apply(row[first / WORD_BITS], firstMask & lastMask, first / WORD_BITS);
+                return;
+            }
+
+            apply(row[first / WORD_BITS], firstMask, first / WORD_BITS);
+            for (int index = first / WORD_BITS + 1; index < last / WORD_BITS; index++)
+            {
+                apply(row[index], ALL_BITS, index);
+            }
+            apply(row[last / WORD_BITS], lastMask, last / WORD_BITS);
+        }
+    }
+
+    BitBuffer::BitBuffer(const Rect& bounds) : _bounds(Rect::empty()), _wordsPerRow(0), _hasRun(false), _runY(0), _runLeft(0), _runRight(0)
+    {
+        this->reset(bounds);
+    }
+
+    void BitBuffer::reset(const Rect& bounds)
+    {
+        this->_bounds = bounds;
+        this->_hasRun = false;
+
+        if (bounds.isEmpty())
+        {
+            this->_wordsPerRow = 0;
+            this->_words.clear();
+            return;
+        }
+
+        const size_t width = static_cast<size_t>(bounds.right - bounds.left + 1);
+        const size_t height = static_cast<size_t>(bounds.top - bounds.bottom + 1);
+        this->_wordsPerRow = (width + WORD_BITS - 1) / WORD_BITS;
+        // assign 不會釋放已配置的記憶體
+        this->_words.assign(this->_wordsPerRow * height, 0);
+    }
+
+    const Rect& BitBuffer::getBounds() const
+    {
+        return this->_bounds;
+    }
+
+    bool BitBuffer::get(int x, int y) const
+    {
+        if (!this->_bounds.contains(x, y))
+        {
+            return false;
+        }
+
+        const int column = x - this->_bounds.left;
+        const uint64_t word = this->_words[static_cast<size_t>(y - this->_bounds.bottom) * this->_wordsPerRow + column / WORD_BITS];
+        return (word >> (column % WORD_BITS)) & 1;
+    }
+
+    void BitBuffer::plot(int x, int y)
+    {
+        if (this->_hasRun && y == this->_runY && x == this->_runRight + 1)
+        {
+            this->_runRight = x;
+            return;
+        }
+
+        this->flush();
+        this->_hasRun = true;
+        this->_runY = y;
+        this->_runLeft = x;
+        this->_runRight = x;
+    }
+
+    void BitBuffer::flush()
+    {
+        if (this->_hasRun)
+        {
+            this->setSpan(this->_runY, this->_runLeft, this->_runRight);
+            this->_hasRun = false;
+        }
+    }
+
+    void BitBuffer::setSpan(int y, int left, int right)
+    {
+        const Rect span = Rect{left, y, right, y}.intersected(this->_bounds);
+        if (span.isEmpty())
+        {
+            return;
+        }
+
+        uint64_t* row = this->_words.data() + static_cast<size_t>(y - this->_bounds.bottom) * this->_wordsPerRow;
+        forEachMaskedWord(row, span.left - this->_bounds.left, span.right - this->_bounds.left, [](uint64_t& word, uint64_t mask, int)
+        {
+            word |= mask;
+        });
+    }
+
+    void BitBuffer::clear(const Rect& area)
+    {
+        this->flush();
+
+        const Rect clipped = area.intersected(this->_bounds);
+        if (clipped.isEmpty())
+        {
+            return;
+        }
+
+        for (int y = clipped.bottom; y <= clipped.top; y++)
+        {
+            uint64_t* row = this->_words.data() + static_cast<size_t>(y - this->_bounds.bottom) * this->_wordsPerRow;
+            forEachMaskedWord(row, clipped.left - this->_bounds.left, clipped.right - this->_bounds.left, [](uint64_t& word, uint64_t mask, int)
+            {
+                word &= ~mask;
+            });
+        }
+    }
+
+    size_t BitBuffer::count() const
+    {
+        return this->count(this->_bounds);
+    }
+
+    size_t BitBuffer::count(const Rect& area) const
+    {
+        const Rect clipped = area.intersected(this->_bounds);
+        if (clipped.isEmpty())
+        {
+            return 0;
+        }
+
+        size_t total = 0;
+        for (int y = clipped.bottom; y <= clipped.top; y++)
+        {
+            const uint64_t* row = this->_words.data() + static_cast<size_t>(y - this->_bounds.bottom) * this->_wordsPerRow;
+            forEachMaskedWord(row, clipped.left - this->_bounds.left, clipped.right - this->_bounds.left, [&total](const uint64_t& word, uint64_t mask, int)
+            {
+                total += static_cast<size_t>(countBits(word & mask));
+            });
+        }
+        return total;
+    }
+
+    Rect BitBuffer::getOccupiedBounds() const
+    {
+        Rect occupied = Rect::empty();
+        const int height = this->_bounds.isEmpty() ? 0 : this->_bounds.top - this->_bounds.bottom + 1;
+
+        for (int row = 0; row < height; row++)
+        {
+            const uint64_t* words = this->_words.data() + static_cast<size_t>(row) * this->_wordsPerRow;
+            const uint64_t* end = words + this->_wordsPerRow;
+            const uint64_t* first = std::find_if(words, end, [](uint64_t word) { return word != 0; });
+            if (first == end)
+            {
+                continue;
+            }
+
+            const uint64_t* last = end - 1;
+            while (*last == 0)
+            {
+                last--;
+            }
+
+            const int y = this->_bounds.bottom + row;
+            const int left = this->_bounds.left + static_cast<int>(first - words) * WORD_BITS + findLowestBit(*first);
+            const int right = this->_bounds.left + static_cast<int>(last - words) * WORD_BITS + findHighestBit(*last);
+            occupied = occupied.united(Rect{left, y, right, y});
+        }
+        return occupied;
+    }
+
+    template <typename Visitor>
+    void BitBuffer::forEachSetCell(const Rect& area, Visitor visit) const
+    {
+        const Rect clipped = area.intersected(this->_bounds);
+        if (clipped.isEmpty())
+        {
+            return;
+        }
+
+        for (int y = clipped.bottom; y <= clipped.top; y++)
+        {
+            const uint64_t* row = this->_words.data() + static_cast<size_t>(y - this->_bounds.bottom) * this->_wordsPerRow;
+            forEachMaskedWord(row, clipped.left - this->_bounds.left, clipped.right - this->_bounds.left, [&](const uint64_t& word, uint64_t mask, int index)
+            {
+                // 一次略過 64 個空的格子，只走訪被設定的 bit
+                uint64_t bits = word & mask;
+                while (bits != 0)
+                {
+                    visit(this->_bounds.left + index * WORD_BITS + findLowestBit(bits), y);
+                    bits &= bits - 1;
+                }
+            });
+        }
+    }
+
+    void BitBuffer::resolve(CoveragePyramid& target, const Rect& area) const
+    {
+        this->forEachSetCell(area, [&](int x, int y)
+        {
+            target.blend(x, y, 1.0);
+        });
+    }
+
+    void BitBuffer::resolve(uint8_t* destination, const Rect& area) const
+    {
+        const size_t width = area.isEmpty() ? 0 : static_cast<size_t>(area.right - area.left + 1);
+        this->forEachSetCell(area, [&](int x, int y)
+        {
+            destination[static_cast<size_t>(y - area.bottom) * width + (x - area.left)] = 255;
+        });
+    }
+}
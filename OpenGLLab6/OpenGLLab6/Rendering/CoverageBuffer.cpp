@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <vector>
+
+#include "../rendering.h"
+
+namespace Rendering
+{
+    CoverageBuffer::CoverageBuffer(int extent) : _extent(extent), _width(2 * extent + 1), _alpha(static_cast<size_t>(_width) * _width, 0.0f)
+    {
+    }
+
+    int CoverageBuffer::getExtent() const
+    {
+        return this->_extent;
+    }
+
+    double CoverageBuffer::getAlpha(int x, int y) const
+    {
+        if (x < -this->_extent || x > this->_extent || y < -this->_extent || y > this->_extent)
+        {
+            return 0.0;
+        }
+        return this->_alpha[static_cast<size_t>(y + this->_extent) * this->_width + (x + this->_extent)];
+    }
+
+    void CoverageBuffer::blend(int x, int y, double alpha)
+    {
+        if (x < -this->_extent || x > this->_extent || y < -this->_extent || y > this->_extent)
+        {
+            return;
+        }
+        float& destination = this->_alpha[static_cast<size_t>(y + this->_extent) * this->_width + (x + this->_extent)];
+        destination = static_cast<float>(alpha + destination * (1.0 - alpha));
+    }
+
+    void CoverageBuffer::clear()
+    {
+        std::fill(this->_alpha.begin(), this->_alpha.end(), 0.0f);
+    }
+
+    void CoverageBuffer::clear(const Rect& area)
+    {
+        const Rect clipped = area.intersected(this->getBounds());
+        if (clipped.isEmpty())
+        {
+            return;
+        }
+
+        for (int y = clipped.bottom; y <= clipped.top; y++)
+        {
+            const auto row = this->_alpha.begin() + static_cast<size_t>(y + this->_extent) * this->_width;
+            std::fill(row + (clipped.left + this->_extent), row + (clipped.right + this->_extent + 1), 0.0f);
+        }
+    }
+
+    void CoverageBuffer::copy(const CoverageBuffer& source, const Rect& area)
+    {
+        const Rect clipped = area.intersected(this->getBounds());
+        if (clipped.isEmpty())
+        {
+            return;
+        }
+
+        for (int y = clipped.bottom; y <= clipped.top; y++)
+        {
+            const size_t offset = static_cast<size_t>(y + this->_extent) * this->_width;
+            std::copy(source._alpha.begin() + offset + (clipped.left + this->_extent),
+                      source._alpha.begin() + offset + (clipped.right + this->_extent + 1),
+                      this->_alpha.begin() + offset + (clipped.left + this->_extent));
+        }
+    }
+
+    Rect CoverageBuffer::getBounds() const
+    {
+        return Rect{-this->_extent, -this->_extent, this->_extent, this->_extent};
+    }
+}
@@ -0,0 +1,124 @@
+﻿#include <algorithm>
+#include <vector>
+
+#include "../rendering.h"
+
+namespace Rendering
+{
+    CoveragePyramid::CoveragePyramid(int extent) : _base(extent)
+    {
+        int width = 2 * extent + 1;
+        while (width > 1)
+        {
+            width = (width + 1) / 2;
+            this->_widths.push_back(width);
+            this->_levels.emplace_back(static_cast<size_t>(width) * width, 0.0f);
+        }
+    }
+
+    int CoveragePyramid::getExtent() const
+    {
+        return this->_base.getExtent();
+    }
+
+    int CoveragePyramid::getLevelCount() const
+    {
+        return static_cast<int>(this->_levels.size()) + 1;
+    }
+
+    int CoveragePyramid::getLevelWidth(int level) const
+    {
+        return level == 0 ? 2 * this->getExtent() + 1 : this->_widths[level - 1];
+    }
+
+    double CoveragePyramid::getAlpha(int level, int column, int row) const
+    {
+        if (level == 0)
+        {
+            return this->_base.getAlpha(column - this->getExtent(), row - this->getExtent());
+        }
+
+        const int width = this->_widths[level - 1];
+        if (column < 0 || column >= width || row < 0 || row >= width)
+        {
+            return 0.0;
+        }
+        return this->_levels[level - 1][static_cast<size_t>(row) * width + column];
+    }
+
+    void CoveragePyramid::blend(int x, int y, double alpha)
+    {
+        this->_base.blend(x, y, alpha);
+    }
+
+    void CoveragePyramid::clear(const Rect& area)
+    {
+        this->_base.clear(area);
+    }
+
+    Rect CoveragePyramid::toLevelArea(const Rect& area, int level) const
+    {
+        const int extent = this->getExtent();
+        const Rect clipped = area.intersected(this->_base.getBounds());
+        if (clipped.isEmpty())
+        {
+            return Rect::empty();
+        }
+
+        // 索引皆為非負數，右移即為除以 2^level 後無條件捨去
+        return Rect{
+            (clipped.left + extent) >> level,
+            (clipped.bottom + extent) >> level,
+            (clipped.right + extent) >> level,
+            (clipped.top + extent) >> level};
+    }
+
+    void CoveragePyramid::update(const Rect& area)
+    {
+        for (int level = 1; level < this->getLevelCount(); level++)
+        {
+            const Rect levelArea = this->toLevelArea(area, level);
+            if (levelArea.isEmpty())
+            {
+                return;
+            }
+
+            const int width = this->_widths[level - 1];
+            std::vector<float>& cells = this->_levels[level - 1];
+            for (int row = levelArea.bottom; row <= levelArea.top; row++)
+            {
+                for (int column = levelArea.left; column <= levelArea.right; column++)
+                {
+                    const double sum = this->getAlpha(level - 1, 2 * column, 2 * row) +
+                                       this->getAlpha(level - 1, 2 * column + 1, 2 * row) +
+                                       this->getAlpha(level - 1, 2 * column, 2 * row + 1) +
+                                       this->getAlpha(level - 1, 2 * column + 1, 2 * row + 1);
+                    cells[static_cast<size_t>(row) * width + column] = static_cast<float>(sum / 4.0);
+                }
+            }
+        }
+    }
+
+    void CoveragePyramid::copy(const CoveragePyramid& source, const Rect& area)
+    {
+        this->_base.copy(source._base, area);
+
+        for (int level = 1; level < this->getLevelCount(); level++)
+        {
+            const Rect levelArea = this->toLevelArea(area, level);
+            if (levelArea.isEmpty())
+            {
+                return;
+            }
+
+            const int width = this->_widths[level - 1];
+            for (int row = levelArea.bottom; row <= levelArea.top; row++)
+            {
+                const size_t offset = static_cast<size_t>(row) * width;
+                std::copy(source._levels[level - 1].begin() + offset + levelArea.left,
+                          source._levels[level - 1].begin() + offset + levelArea.right + 1,
+                          this->_levels[level - 1].begin() + offset + levelArea.left);
+            }
+        }
+    }
+}
@@ -0,0 +1,197 @@
+﻿#include <cmath>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../rendering.h"
+
+namespace Rendering
+{
+    RasterWorker::RasterWorker(int extent)
+        : _bits(Rect::empty()), _clipArea(Rect::empty()), _isAliasedJob(false),
+          _buffers{{CoveragePyramid(extent), CoveragePyramid(extent), CoveragePyramid(extent)}},
+          _staleAreas{{Rect::empty(), Rect::empty(), Rect::empty()}},
+          _frontIndex(0), _backIndex(2), _middle(1), _generation(0), _completedGeneration(0),
+          _pendingAlgorithm(nullptr), _pendingArea(Rect::empty()), _hasPendingJob(false), _isStopping(false)
+    {
+    }
+
+    RasterWorker::~RasterWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->_jobMutex);
+            this->_isStopping = true;
+            this->_generation++;
+        }
+        this->_jobCondition.notify_one();
+
+        if (this->_thread.joinable())
+        {
+            this->_thread.join();
+        }
+    }
+
+    Algorithms::Callback RasterWorker::getPixelWriter()
+    {
+        return [this](double centerX, double centerY, double alpha)
+        {
+            const int x = static_cast<int>(std::round(centerX));
+            const int y = static_cast<int>(std::round(centerY));
+            if (!this->_clipArea.contains(x, y))
+            {
+                return;
+            }
+
+            if (this->_isAliasedJob)
+            {
+                this->_bits.plot(x, y);
+            }
+            else
+            {
+                this->_master->blend(x, y, alpha);
+            }
+        };
+    }
+
+    void RasterWorker::start()
+    {
+        this->_thread = std::thread(&RasterWorker::run, this);
+    }
+
+    unsigned long long RasterWorker::submit(const std::vector<Segment>& segments, const Algorithms::Algorithm* algorithm, const Rect& area)
+    {
+        unsigned long long generation;
+        {
+            std::lock_guard<std::mutex> lock(this->_jobMutex);
+            this->_pendingSegments = segments;
+            this->_pendingAlgorithm = algorithm;
+            this->_pendingArea = area;
+            this->_hasPendingJob = true;
+            generation = ++this->_generation;
+        }
+        this->_jobCondition.notify_one();
+        return generation;
+    }
+
+    unsigned long long RasterWorker::getCompletedGeneration() const
+    {
+        return this->_completedGeneration.load(std::memory_order_acquire);
+    }
+
+    bool RasterWorker::hasNewFrame() const
+    {
+        return (this->_middle.load(std::memory_order_acquire) & FRESH_FLAG) != 0;
+    }
+
+    const CoveragePyramid& RasterWorker::acquireFrame()
+    {
+        if (this->hasNewFrame())
+        {
+            this->_frontIndex = this->_middle.exchange(this->_frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+        return this->_buffers[this->_frontIndex];
+    }
+
+    void RasterWorker::run()
+    {
+        std::vector<Segment> segments;
+
+        while (true)
+        {
+            const Algorithms::Algorithm* algorithm;
+            unsigned long long generation;
+            {
+                std::unique_lock<std::mutex> lock(this->_jobMutex);
+                this->_jobCondition.wait(lock, [this]() { return this->_hasPendingJob || this->_isStopping; });
+                if (this->_isStopping)
+                {
+                    return;
+                }
+
+                segments.swap(this->_pendingSegments);
+                algorithm = this->_pendingAlgorithm;
+                this->_clipArea = this->_pendingArea;
+                generation = this->_generation.load();
+                this->_hasPendingJob = false;
+            }
+
+            // 只保留目前這種演算法需要的完整結果，切換時釋放另一種的記憶體；
+            // 被取消的工作留下的格子會由下一個工作的範圍涵蓋
+            this->_isAliasedJob = !algorithm->isAntiAliased();
+            const int extent = this->_buffers.front().getExtent();
+            if (this->_isAliasedJob)
+            {
+                this->_master.reset();
+                if (this->_bits.getBounds().isEmpty())
+                {
+                    this->_bits.reset(Rect{-extent, -extent, extent, extent});
+                }
+                this->_bits.clear(this->_clipArea);
+            }
+            else
+            {
+                this->_bits = BitBuffer(Rect::empty());
+                if (!this->_master)
+                {
+                    this->_master = std::make_unique<CoveragePyramid>(extent);
+                }
+                this->_master->clear(this->_clipArea);
+            }
+
+            // 線段只走訪重畫範圍內的部分，移動短線段時不必重畫與它交錯的長線段全長
+            const Algorithms::ClipWindow clip{this->_clipArea.left, this->_clipArea.bottom, this->_clipArea.right, this->_clipArea.top};
+            bool isCancelled = false;
+            for (const Segment& segment : segments)
+            {
+                // 有新的工作進來就放棄目前的結果
+                if (this->_generation.load(std::memory_order_relaxed) != generation)
+                {
+                    isCancelled = true;
+                    break;
+                }
+                algorithm->apply(segment.first, segment.second, clip);
+            }
+
+            if (!isCancelled)
+            {
+                if (this->_isAliasedJob)
+                {
+                    this->_bits.flush();
+                }
+                else
+                {
+                    this->_master->update(this->_clipArea);
+                }
+                for (Rect& staleArea : this->_staleAreas)
+                {
+                    staleArea = staleArea.united(this->_clipArea);
+                }
+                this->publish();
+                // 交接後才標記完成，取得的畫面一定包含此工作
+                this->_completedGeneration.store(generation, std::memory_order_release);
+            }
+        }
+    }
+
+    void RasterWorker::publish()
+    {
+        // back buffer 只需要補上它錯過的範圍
+        Rect& staleArea = this->_staleAreas[this->_backIndex];
+        CoveragePyramid& back = this->_buffers[this->_backIndex];
+        if (this->_isAliasedJob)
+        {
+            back.clear(staleArea);
+            this->_bits.resolve(back, staleArea);
+            back.update(staleArea);
+        }
+        else
+        {
+            back.copy(*this->_master, staleArea);
+        }
+        staleArea = Rect::empty();
+
+        this->_backIndex = this->_middle.exchange(this->_backIndex | FRESH_FLAG, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+}
@@ -0,0 +1,65 @@
+﻿#include <algorithm>
+
+#include "../rendering.h"
+
+namespace Rendering
+{
+    Rect Rect::empty()
+    {
+        return Rect{0, 0, -1, -1};
+    }
+
+    Rect Rect::bounding(const Segment& segment)
+    {
+        const std::pair<int, int>& startPoint = segment.first;
+        const std::pair<int, int>& endPoint = segment.second;
+
+        // 反鋸齒會多畫相鄰的一格，因此四邊各留一格
+        return Rect{
+            std::min(startPoint.first, endPoint.first) - 1,
+            std::min(startPoint.second, endPoint.second) - 1,
+            std::max(startPoint.first, endPoint.first) + 1,
+            std::max(startPoint.second, endPoint.second) + 1};
+    }
+
+    bool Rect::isEmpty() const
+    {
+        return this->left > this->right || this->bottom > this->top;
+    }
+
+    bool Rect::contains(int x, int y) const
+    {
+        return x >= this->left && x <= this->right && y >= this->bottom && y <= this->top;
+    }
+
+    bool Rect::intersects(const Rect& other) const
+    {
+        return !this->intersected(other).isEmpty();
+    }
+
+    Rect Rect::united(const Rect& other) const
+    {
+        if (this->isEmpty())
+        {
+            return other;
+        }
+        if (other.isEmpty())
+        {
+            return *this;
+        }
+        return Rect{
+            std::min(this->left, other.left),
+            std::min(this->bottom, other.bottom),
+            std::max(this->right, other.right),
+            std::max(this->top, other.top)};
+    }
+
+    Rect Rect::intersected(const Rect& other) const
+    {
+        return Rect{
+            std::max(this->left, other.left),
+            std::max(this->bottom, other.bottom),
+            std::min(this->right, other.right),
+            std::min(this->top, other.top)};
+    }
+}
@@ -0,0 +1,101 @@
+﻿#include <algorithm>
+#include <vector>
+
+#include "../rendering.h"
+
+namespace Rendering
+{
+    SegmentIndex::SegmentIndex(int extent, int bucketSize)
+        : _extent(extent), _bucketSize(bucketSize), _bucketsPerRow((2 * extent + 1 + bucketSize - 1) / bucketSize),
+          _buckets(static_cast<size_t>(_bucketsPerRow) * _bucketsPerRow)
+    {
+    }
+
+    int SegmentIndex::toBucket(int value) const
+    {
+        const int clamped = std::min(std::max(value, -this->_extent), this->_extent);
+        return (clamped + this->_extent) / this->_bucketSize;
+    }
+
+    void SegmentIndex::insert(size_t id, const Rect& bounds)
+    {
+        this->_bounds[id] = bounds;
+
+        for (int row = this->toBucket(bounds.bottom); row <= this->toBucket(bounds.top); row++)
+        {
+            for (int column = this->toBucket(bounds.left); column <= this->toBucket(bounds.right); column++)
+            {
+                this->_buckets[static_cast<size_t>(row) * this->_bucketsPerRow + column].push_back(id);
+            }
+        }
+    }
+
+    void SegmentIndex::remove(size_t id)
+    {
+        const auto iter = this->_bounds.find(id);
+        if (iter == this->_bounds.end())
+        {
+            return;
+        }
+
+        const Rect bounds = iter->second;
+        this->_bounds.erase(iter);
+
+        for (int row = this->toBucket(bounds.bottom); row <= this->toBucket(bounds.top); row++)
+        {
+            for (int column = this->toBucket(bounds.left); column <= this->toBucket(bounds.right); column++)
+            {
+                std::vector<size_t>& bucket = this->_buckets[static_cast<size_t>(row) * this->_bucketsPerRow + column];
+                const auto found = std::find(bucket.begin(), bucket.end(), id);
+                if (found != bucket.end())
+                {
+                    // bucket 內的順序不重要，與最後一個交換後移除
+                    std::swap(*found, bucket.back());
+                    bucket.pop_back();
+                }
+            }
+        }
+    }
+
+    void SegmentIndex::clear()
+    {
+        for (std::vector<size_t>& bucket : this->_buckets)
+        {
+            bucket.clear();
+        }
+        this->_bounds.clear();
+    }
+
+    std::vector<size_t> SegmentIndex::query(const Rect& area) const
+    {
+        std::vector<size_t> result;
+        if (area.isEmpty())
+        {
+            return result;
+        }
+
+        for (int row = this->toBucket(area.bottom); row <= this->toBucket(area.top); row++)
+        {
+            for (int column = this->toBucket(area.left); column <= this->toBucket(area.right); column++)
+            {
+                for (const size_t& id : this->_buckets[static_cast<size_t>(row) * this->_bucketsPerRow + column])
+                {
+                    if (this->_bounds.at(id).intersects(area))
+                    {
+                        result.push_back(id);
+                    }
+                }
+            }
+        }
+
+        // 跨越多個 bucket 的線段會重複出現
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+    std::vector<size_t> SegmentIndex::query(int x, int y) const
+    {
+        return this->query(Rect{x, y, x, y});
+    }
+}
@@ -0,0 +1,134 @@
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../server.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace Server
+{
+#ifdef _WIN32
+    RenderClient::RenderClient(const std::string&) : _socket(-1)
+    {
+        throw std::runtime_error("render client requires Unix domain sockets");
+    }
+
+    RenderClient::~RenderClient() = default;
+
+    ResponseHeader RenderClient::render(uint32_t, const std::vector<Rendering::Segment>&, std::vector<uint8_t>&)
+    {
+        throw std::runtime_error("render client requires Unix domain sockets");
+    }
+#else
+    namespace
+    {
+        void sendAll(int fd, const void* data, size_t size)
+        {
+            const char* bytes = static_cast<const char*>(data);
+            while (size > 0)
+            {
+                const ssize_t sent = send(fd, bytes, size, 0);
+                if (sent < 0 && errno != EINTR)
+                {
+                    throw std::runtime_error(std::string("send: ") + std::strerror(errno));
+                }
+                if (sent > 0)
+                {
+                    bytes += sent;
+                    size -= static_cast<size_t>(sent);
+                }
+            }
+        }
+
+        void receiveAll(int fd, void* data, size_t size)
+        {
+            char* bytes = static_cast<char*>(data);
+            while (size > 0)
+            {
+                const ssize_t received = recv(fd, bytes, size, 0);
+                if (received == 0)
+                {
+                    throw std::runtime_error("server closed the connection");
+                }
+                if (received < 0 && errno != EINTR)
+                {
+                    throw std::runtime_error(std::string("recv: ") + std::strerror(errno));
+                }
+                if (received > 0)
+                {
+                    bytes += received;
+                    size -= static_cast<size_t>(received);
+                }
+            }
+        }
+    }
+
+    RenderClient::RenderClient(const std::string& socketPath) : _socket(socket(AF_UNIX, SOCK_STREAM, 0))
+    {
+        if (this->_socket < 0)
+        {
+            throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+        }
+
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path))
+        {
+            close(this->_socket);
+            throw std::runtime_error("socket path is too long: " + socketPath);
+        }
+        std::strcpy(address.sun_path, socketPath.c_str());
+
+        if (connect(this->_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+        {
+            const std::string message = std::string("connect: ") + std::strerror(errno);
+            close(this->_socket);
+            throw std::runtime_error(message);
+        }
+    }
+
+    RenderClient::~RenderClient()
+    {
+        close(this->_socket);
+    }
+
+    ResponseHeader RenderClient::render(uint32_t algorithm, const std::vector<Rendering::Segment>& segments, std::vector<uint8_t>& coverage)
+    {
+        const RequestHeader request{REQUEST_MAGIC, algorithm, static_cast<uint32_t>(segments.size())};
+        std::vector<int32_t> coordinates;
+        coordinates.reserve(segments.size() * 4);
+        for (const Rendering::Segment& segment : segments)
+        {
+            coordinates.push_back(segment.first.first);
+            coordinates.push_back(segment.first.second);
+            coordinates.push_back(segment.second.first);
+            coordinates.push_back(segment.second.second);
+        }
+
+        sendAll(this->_socket, &request, sizeof(request));
+        sendAll(this->_socket, coordinates.data(), coordinates.size() * sizeof(int32_t));
+
+        ResponseHeader response;
+        receiveAll(this->_socket, &response, sizeof(response));
+        if (response.magic != RESPONSE_MAGIC)
+        {
+            throw std::runtime_error("unexpected response from server");
+        }
+
+        coverage.clear();
+        if (response.status == STATUS_OK && response.left <= response.right && response.bottom <= response.top)
+        {
+            coverage.resize(static_cast<size_t>(response.right - response.left + 1) * (response.top - response.bottom + 1));
+            receiveAll(this->_socket, coverage.data(), coverage.size());
+        }
+        return response;
+    }
+#endif
+}
@@ -0,0 +1,553 @@
+﻿#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../server.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace Server
+{
+    // worker thread 每次上鎖最多取走的 request 數與線段數；取走的 request 仍逐一光柵化與回應，只是減少上鎖的次數
+    constexpr size_t MAX_BATCH_JOBS = 16;
+    constexpr size_t MAX_BATCH_SEGMENTS = 4096;
+    // 每次從 socket 讀取的大小
+    constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+
+    RenderServer::RenderServer(const std::string& socketPath, const Algorithms::Registry& registry, unsigned int threadCount)
+        : _socketPath(socketPath), _registry(registry), _threadCount(std::max(threadCount, 1u)),
+          _listenSocket(-1), _isSocketBound(false), _wakePipe{-1, -1}, _nextConnectionId(0), _isStopping(false)
+    {
+    }
+
+    void RenderServer::render(Job& job, const std::vector<std::unique_ptr<Algorithms::Algorithm>>& algorithms, WorkerState& state) const
+    {
+        const Algorithms::Algorithm& algorithm = *algorithms[job.algorithm];
+        const Rendering::Rect& bounds = state.bounds;
+
+        // 重複使用同一塊記憶體，只有變大時才會重新配置
+        state.isAliased = !algorithm.isAntiAliased();
+        if (state.isAliased)
+        {
+            state.bits.reset(bounds);
+        }
+        else
+        {
+            state.coverage.assign(bounds.isEmpty() ? 0 : static_cast<size_t>(bounds.right - bounds.left + 1) * (bounds.top - bounds.bottom + 1), 0.0f);
+        }
+
+        for (const Rendering::Segment& segment : job.segments)
+        {
+            algorithm.apply(segment.first, segment.second);
+        }
+
+        // 沒有反鋸齒時只回傳實際被畫到的範圍
+        if (state.isAliased)
+        {
+            state.bits.flush();
+        }
+        const Rendering::Rect area = state.isAliased ? state.bits.getOccupiedBounds() : bounds;
+        const size_t width = area.isEmpty() ? 0 : static_cast<size_t>(area.right - area.left + 1);
+        const size_t height = area.isEmpty() ? 0 : static_cast<size_t>(area.top - area.bottom + 1);
+
+        job.response.assign(sizeof(ResponseHeader) + width * height, 0);
+        uint8_t* const coverage = job.response.data() + sizeof(ResponseHeader);
+        size_t drawnCount;
+        if (state.isAliased)
+        {
+            state.bits.resolve(coverage, area);
+            drawnCount = state.bits.count();
+        }
+        else
+        {
+            std::transform(state.coverage.begin(), state.coverage.end(), coverage, [](float alpha)
+            {
+                return static_cast<uint8_t>(std::lround(std::min(std::max(alpha, 0.0f), 1.0f) * 255.0f));
+            });
+            drawnCount = static_cast<size_t>(std::count_if(coverage, coverage + width * height, [](uint8_t alpha) { return alpha != 0; }));
+        }
+
+        const ResponseHeader header{RESPONSE_MAGIC, STATUS_OK, area.left, area.bottom, area.right, area.top, static_cast<uint32_t>(drawnCount)};
+        std::memcpy(job.response.data(), &header, sizeof(header));
+    }
+
+#ifdef _WIN32
+    RenderServer::~RenderServer() = default;
+
+    void RenderServer::run()
+    {
+        throw std::runtime_error("render server requires Unix domain sockets");
+    }
+#else
+    namespace
+    {
+        // 是否已經收到一個完整的 request，格式錯誤也算，交給 dispatchRequests 處理
+        bool hasCompleteRequest(const std::vector<uint8_t>& input)
+        {
+            if (input.size() < sizeof(RequestHeader))
+            {
+                return false;
+            }
+
+            RequestHeader header;
+            std::memcpy(&header, input.data(), sizeof(header));
+            if (header.magic != REQUEST_MAGIC || header.segmentCount > MAX_SEGMENTS)
+            {
+                return true;
+            }
+            return input.size() >= sizeof(header) + header.segmentCount * 4 * sizeof(int32_t);
+        }
+
+        // 是否為沒有 server 在聽的 socket 檔，可以安全地移除
+        bool isStaleSocket(const sockaddr_un& address)
+        {
+            struct stat status;
+            if (lstat(address.sun_path, &status) < 0 || !S_ISSOCK(status.st_mode))
+            {
+                return false;
+            }
+
+            const int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (probe < 0)
+            {
+                return false;
+            }
+            const bool isRefused = connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 && errno == ECONNREFUSED;
+            close(probe);
+            return isRefused;
+        }
+
+        // 加入沒有透明度資料的錯誤回應
+        void appendErrorResponse(std::vector<uint8_t>& output, Status status)
+        {
+            const ResponseHeader response{RESPONSE_MAGIC, status, 0, 0, -1, -1, 0};
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&response);
+            output.insert(output.end(), bytes, bytes + sizeof(response));
+        }
+    }
+
+    RenderServer::~RenderServer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->_jobMutex);
+            this->_isStopping = true;
+        }
+        this->_jobCondition.notify_all();
+        for (std::thread& worker : this->_workers)
+        {
+            worker.join();
+        }
+
+        for (const auto& iter : this->_connections)
+        {
+            close(iter.second.socket);
+        }
+        for (const int& fd : this->_wakePipe)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+        if (this->_listenSocket >= 0)
+        {
+            close(this->_listenSocket);
+        }
+        // 只移除自己建立的 socket 檔
+        if (this->_isSocketBound)
+        {
+            unlink(this->_socketPath.c_str());
+        }
+    }
+
+    void RenderServer::run()
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (this->_socketPath.size() >= sizeof(address.sun_path))
+        {
+            throw std::runtime_error("socket path is too long: " + this->_socketPath);
+        }
+        std::strcpy(address.sun_path, this->_socketPath.c_str());
+
+        // 客戶端斷線時 send 不要結束整個 process
+        std::signal(SIGPIPE, SIG_IGN);
+
+        this->_listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (this->_listenSocket < 0)
+        {
+            throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+        }
+        // 只移除上次沒有清掉的 socket 檔，其他檔案或仍有 server 在聽的 socket 不能動
+        struct stat status;
+        if (lstat(this->_socketPath.c_str(), &status) == 0)
+        {
+            if (!isStaleSocket(address))
+            {
+                throw std::runtime_error("address in use: " + this->_socketPath);
+            }
+            unlink(this->_socketPath.c_str());
+        }
+        if (bind(this->_listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+        {
+            throw std::runtime_error(std::string("bind: ") + std::strerror(errno));
+        }
+        this->_isSocketBound = true;
+        if (listen(this->_listenSocket, SOMAXCONN) < 0)
+        {
+            throw std::runtime_error(std::string("listen: ") + std::strerror(errno));
+        }
+        fcntl(this->_listenSocket, F_SETFL, O_NONBLOCK);
+
+        if (pipe(this->_wakePipe) < 0)
+        {
+            throw std::runtime_error(std::string("pipe: ") + std::strerror(errno));
+        }
+        fcntl(this->_wakePipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(this->_wakePipe[1], F_SETFL, O_NONBLOCK);
+
+        for (unsigned int i = 0; i < this->_threadCount; i++)
+        {
+            this->_workers.emplace_back(&RenderServer::work, this);
+        }
+
+        std::vector<pollfd> fds;
+        std::vector<unsigned long long> ids;
+        while (true)
+        {
+            fds.clear();
+            ids.clear();
+            fds.push_back(pollfd{this->_listenSocket, POLLIN, 0});
+            fds.push_back(pollfd{this->_wakePipe[0], POLLIN, 0});
+            for (const auto& iter : this->_connections)
+            {
+                // 處理中的連線只預先收下一個 request，其餘留在 socket 裡，避免客戶端塞爆記憶體；對方已關閉寫入時不再讀取
+                const bool isReading = !iter.second.isReadClosed && (!iter.second.isBusy || !hasCompleteRequest(iter.second.input));
+                const short events = static_cast<short>((isReading ? POLLIN : 0) | (iter.second.output.empty() ? 0 : POLLOUT));
+                fds.push_back(pollfd{iter.second.socket, events, 0});
+                ids.push_back(iter.first);
+            }
+
+            if (poll(fds.data(), fds.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::runtime_error(std::string("poll: ") + std::strerror(errno));
+            }
+
+            if (fds[1].revents & POLLIN)
+            {
+                char buffer[64];
+                while (read(this->_wakePipe[0], buffer, sizeof(buffer)) > 0)
+                {
+                }
+                this->collectResponses();
+            }
+            if (fds[0].revents & POLLIN)
+            {
+                this->acceptConnections();
+            }
+
+            for (size_t i = 0; i < ids.size(); i++)
+            {
+                const short revents = fds[i + 2].revents;
+                if (revents & POLLOUT)
+                {
+                    this->writeConnection(ids[i]);
+                }
+                if (!(fds[i + 2].events & POLLIN) && (revents & (POLLHUP | POLLERR)))
+                {
+                    this->closeConnection(ids[i]);
+                }
+                else if (revents & (POLLIN | POLLHUP | POLLERR))
+                {
+                    this->readConnection(ids[i]);
+                }
+            }
+        }
+    }
+
+    void RenderServer::work()
+    {
+        WorkerState state{Rendering::Rect::empty(), {}, Rendering::BitBuffer(Rendering::Rect::empty()), false};
+
+        // 每個 worker thread 各自擁有演算法，畫到自己的 buffer
+        const Algorithms::Callback setPixel = [&state](double centerX, double centerY, double alpha)
+        {
+            const int x = static_cast<int>(std::round(centerX));
+            const int y = static_cast<int>(std::round(centerY));
+            const Rendering::Rect& bounds = state.bounds;
+            if (!bounds.contains(x, y))
+            {
+                return;
+            }
+            if (state.isAliased)
+            {
+                state.bits.plot(x, y);
+                return;
+            }
+            float& destination = state.coverage[static_cast<size_t>(y - bounds.bottom) * (bounds.right - bounds.left + 1) + (x - bounds.left)];
+            destination = static_cast<float>(alpha + destination * (1.0 - alpha));
+        };
+        const std::vector<std::unique_ptr<Algorithms::Algorithm>> algorithms = this->_registry.createAll(setPixel);
+
+        std::vector<std::unique_ptr<Job>> batch;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(this->_jobMutex);
+                this->_jobCondition.wait(lock, [this]() { return !this->_pendingJobs.empty() || this->_isStopping; });
+                if (this->_isStopping)
+                {
+                    return;
+                }
+
+                // 一次取走多個小 request，減少上鎖的次數；最多取走平分給每個 thread 的份量，其他 worker 仍有工作可做
+                const size_t jobLimit = std::min(std::max<size_t>(this->_pendingJobs.size() / this->_threadCount, 1), MAX_BATCH_JOBS);
+                size_t segmentCount = 0;
+                while (!this->_pendingJobs.empty() && batch.size() < jobLimit && (batch.empty() || segmentCount + this->_pendingJobs.front()->segments.size() <= MAX_BATCH_SEGMENTS))
+                {
+                    segmentCount += this->_pendingJobs.front()->segments.size();
+                    batch.push_back(std::move(this->_pendingJobs.front()));
+                    this->_pendingJobs.pop_front();
+                }
+            }
+
+            for (std::unique_ptr<Job>& job : batch)
+            {
+                if (job->algorithm == ALGORITHM_AUTO || job->algorithm == ALGORITHM_AUTO_ANTI_ALIASING)
+                {
+                    // 沒有相符且 CPU 支援的演算法時回應錯誤，不改用另一種演算法
+                    size_t index;
+                    if (!this->_registry.select(job->algorithm == ALGORITHM_AUTO_ANTI_ALIASING, job->segments, index))
+                    {
+                        appendErrorResponse(job->response, STATUS_UNKNOWN_ALGORITHM);
+                        this->completeJob(std::move(job));
+                        continue;
+                    }
+                    job->algorithm = static_cast<uint32_t>(index);
+                }
+
+                state.bounds = Rendering::Rect::empty();
+                for (const Rendering::Segment& segment : job->segments)
+                {
+                    state.bounds = state.bounds.united(Rendering::Rect::bounding(segment));
+                }
+                this->render(*job, algorithms, state);
+                // 每個 request 完成就立刻回應，不必等同一批的其他 request
+                this->completeJob(std::move(job));
+            }
+            batch.clear();
+        }
+    }
+
+    void RenderServer::completeJob(std::unique_ptr<Job> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->_completedMutex);
+            this->_completedJobs.push_back(std::move(job));
+        }
+
+        const char wake = 1;
+        if (write(this->_wakePipe[1], &wake, 1) < 0)
+        {
+            // pipe 已滿表示 poll 一定會被喚醒
+        }
+    }
+
+    void RenderServer::acceptConnections()
+    {
+        while (true)
+        {
+            const int client = accept(this->_listenSocket, nullptr, nullptr);
+            if (client < 0)
+            {
+                return;
+            }
+            fcntl(client, F_SETFL, O_NONBLOCK);
+            this->_connections.emplace(this->_nextConnectionId++, Connection{client, {}, {}, false, false});
+        }
+    }
+
+    void RenderServer::readConnection(unsigned long long id)
+    {
+        const auto iter = this->_connections.find(id);
+        if (iter == this->_connections.end())
+        {
+            return;
+        }
+        Connection& connection = iter->second;
+
+        const size_t offset = connection.input.size();
+        connection.input.resize(offset + READ_CHUNK_SIZE);
+        const ssize_t size = recv(connection.socket, connection.input.data() + offset, READ_CHUNK_SIZE, 0);
+        if (size == 0)
+        {
+            // 對方不會再送 request，等處理中的 request 回應送出後才關閉
+            connection.input.resize(offset);
+            connection.isReadClosed = true;
+            this->closeIfFinished(id);
+            return;
+        }
+        if (size < 0)
+        {
+            connection.input.resize(offset);
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                this->closeConnection(id);
+            }
+            return;
+        }
+        connection.input.resize(offset + static_cast<size_t>(size));
+
+        if (!this->dispatchRequests(connection, id))
+        {
+            this->closeConnection(id);
+        }
+    }
+
+    void RenderServer::writeConnection(unsigned long long id)
+    {
+        const auto iter = this->_connections.find(id);
+        if (iter == this->_connections.end())
+        {
+            return;
+        }
+        Connection& connection = iter->second;
+
+        const ssize_t size = send(connection.socket, connection.output.data(), connection.output.size(), 0);
+        if (size < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                this->closeConnection(id);
+            }
+            return;
+        }
+        connection.output.erase(connection.output.begin(), connection.output.begin() + size);
+        this->closeIfFinished(id);
+    }
+
+    void RenderServer::closeConnection(unsigned long long id)
+    {
+        const auto iter = this->_connections.find(id);
+        if (iter != this->_connections.end())
+        {
+            close(iter->second.socket);
+            this->_connections.erase(iter);
+        }
+    }
+
+    void RenderServer::closeIfFinished(unsigned long long id)
+    {
+        const auto iter = this->_connections.find(id);
+        if (iter != this->_connections.end() && iter->second.isReadClosed && !iter->second.isBusy && iter->second.output.empty())
+        {
+            this->closeConnection(id);
+        }
+    }
+
+    bool RenderServer::dispatchRequests(Connection& connection, unsigned long long id)
+    {
+        size_t consumed = 0;
+        while (!connection.isBusy && connection.input.size() - consumed >= sizeof(RequestHeader))
+        {
+            RequestHeader header;
+            std::memcpy(&header, connection.input.data() + consumed, sizeof(header));
+            if (header.magic != REQUEST_MAGIC || header.segmentCount > MAX_SEGMENTS)
+            {
+                return false;
+            }
+
+            const size_t requestSize = sizeof(header) + header.segmentCount * 4 * sizeof(int32_t);
+            if (connection.input.size() - consumed < requestSize)
+            {
+                break;
+            }
+
+            std::vector<int32_t> coordinates(header.segmentCount * 4);
+            std::memcpy(coordinates.data(), connection.input.data() + consumed + sizeof(header), coordinates.size() * sizeof(int32_t));
+            consumed += requestSize;
+
+            Status status = STATUS_OK;
+            if (header.algorithm >= this->_registry.size() && header.algorithm != ALGORITHM_AUTO && header.algorithm != ALGORITHM_AUTO_ANTI_ALIASING)
+            {
+                status = STATUS_UNKNOWN_ALGORITHM;
+            }
+            else if (header.algorithm < this->_registry.size() && !this->_registry.isSupported(header.algorithm))
+            {
+                status = STATUS_UNSUPPORTED_ALGORITHM;
+            }
+            else if (std::any_of(coordinates.begin(), coordinates.end(), [](int32_t value) { return value < -MAX_COORDINATE || value > MAX_COORDINATE; }))
+            {
+                status = STATUS_OUT_OF_RANGE;
+            }
+
+            if (status != STATUS_OK)
+            {
+                appendErrorResponse(connection.output, status);
+                continue;
+            }
+
+            std::unique_ptr<Job> job(new Job{id, header.algorithm, {}, {}});
+            job->segments.reserve(header.segmentCount);
+            for (size_t i = 0; i < coordinates.size(); i += 4)
+            {
+                job->segments.emplace_back(std::make_pair(coordinates[i], coordinates[i + 1]), std::make_pair(coordinates[i + 2], coordinates[i + 3]));
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(this->_jobMutex);
+                this->_pendingJobs.push_back(std::move(job));
+            }
+            this->_jobCondition.notify_one();
+            connection.isBusy = true;
+        }
+
+        connection.input.erase(connection.input.begin(), connection.input.begin() + consumed);
+        return true;
+    }
+
+    void RenderServer::collectResponses()
+    {
+        std::vector<std::unique_ptr<Job>> completed;
+        {
+            std::lock_guard<std::mutex> lock(this->_completedMutex);
+            completed.swap(this->_completedJobs);
+        }
+
+        for (const std::unique_ptr<Job>& job : completed)
+        {
+            const auto iter = this->_connections.find(job->connectionId);
+            if (iter == this->_connections.end())
+            {
+                continue;
+            }
+
+            Connection& connection = iter->second;
+            connection.output.insert(connection.output.end(), job->response.begin(), job->response.end());
+            connection.isBusy = false;
+
+            // 已經收到的下一個 request 可以繼續處理
+            if (!this->dispatchRequests(connection, job->connectionId))
+            {
+                this->closeConnection(job->connectionId);
+            }
+        }
+    }
+#endif
+}
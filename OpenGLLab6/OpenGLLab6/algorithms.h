@@ -1,9 +1,30 @@
-﻿#include <string>
+﻿#pragma once
+#include <string>
 #include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
 
 namespace Algorithms
 {
     using Callback = std::function<void(double, double, double)>;
+    // 線段的起點與終點 (格子座標)
+    using Segment = std::pair<std::pair<int, int>, std::pair<int, int>>;
+
+    // 需要畫出的格子範圍 (包含邊界)
+    struct ClipWindow
+    {
+        int left;
+        int bottom;
+        int right;
+        int top;
+
+        /// <summary>
+        /// 不限制範圍
+        /// </summary>
+        /// <returns></returns>
+        static ClipWindow unbounded();
+    };
 
     class Algorithm
     {
@@ -22,10 +43,28 @@ namespace Algorithms
         /// </summary>
         /// <param name="startPoint"></param>
         /// <param name="endPoint"></param>
-        virtual void apply(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint) const = 0;
+        void apply(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint) const;
+
+        /// <summary>
+        /// 使用此演算法，只走訪線段上會落在 clip 內的部分；clip 外仍可能畫到少數格子，畫出的格子與不限制範圍時相同
+        /// </summary>
+        /// <param name="startPoint"></param>
+        /// <param name="endPoint"></param>
+        /// <param name="clip"></param>
+        virtual void apply(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint, const ClipWindow& clip) const = 0;
+
+        /// <summary>
+        /// 是否會畫出透明度小於 1 的格子
+        /// </summary>
+        /// <returns></returns>
+        virtual bool isAntiAliased() const = 0;
     protected:
         // 排序座標
         void sortPoints(std::pair<int, int>& startPoint, std::pair<int, int>& endPoint) const;
+        // 線段沿主軸走 steps 步，第 k 步的主軸座標為 majorStart + k * majorDirection，副軸座標與 minorStart + k * minorSlope 相差不到 1 格；
+        // 計算座標可能落在 [majorMin, majorMax] x [minorMin, minorMax] 內的步數範圍 [first, last]
+        bool clipSteps(int steps, int majorStart, int majorDirection, int majorMin, int majorMax,
+                       double minorStart, double minorSlope, int minorMin, int minorMax, int& first, int& last) const;
         // 畫格子
         const Callback _setPixel;
         // 演算法名稱
@@ -37,17 +76,22 @@ namespace Algorithms
     public:
         explicit MidPointAlgorithm(const Callback& setPixel);
  
+        using Algorithm::apply;
+
         /// <summary>
         /// 使用此演算法
         /// </summary>
         /// <param name="startPoint"></param>
         /// <param name="endPoint"></param>
-        void apply(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint) const override;
+        /// <param name="clip"></param>
+        void apply(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint, const ClipWindow& clip) const override;
+
+        bool isAntiAliased() const override;
     private:
         // 處理斜率為正的線段
-        void rasterizeLineInPositiveSlope(const std::pair<int, int>&, const std::pair<int, int>&, const int&, const int&, const bool&) const;
+        void rasterizeLineInPositiveSlope(const std::pair<int, int>&, const std::pair<int, int>&, const int&, const int&, const bool&, const ClipWindow&) const;
         // 處理斜率為負的線段
-        void rasterizeLineInNegativeSlope(const std::pair<int, int>&, const std::pair<int, int>&, const int&, const int&, const bool&) const;
+        void rasterizeLineInNegativeSlope(const std::pair<int, int>&, const std::pair<int, int>&, const int&, const int&, const bool&, const ClipWindow&) const;
     };
 
     class AntiAliasingAlgorithm final : public Algorithm
@@ -55,16 +99,143 @@ namespace Algorithms
     public:
         explicit AntiAliasingAlgorithm(const Callback& setPixel);
 
+        using Algorithm::apply;
+
         /// <summary>
         /// 使用此演算法
         /// </summary>
         /// <param name="startPoint"></param>
         /// <param name="endPoint"></param>
-        void apply(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint) const override;
+        /// <param name="clip"></param>
+        void apply(const std::pair<int, int>& startPoint, const std::pair<int, int>& endPoint, const ClipWindow& clip) const override;
+
+        bool isAntiAliased() const override;
     private:
         // 處理斜率為正的線段
-        void rasterizeLineInPositiveSlope(const std::pair<int, int>&, const std::pair<int, int>&, const int&, const int&, const bool&) const;
+        void rasterizeLineInPositiveSlope(const std::pair<int, int>&, const std::pair<int, int>&, const int&, const int&, const bool&, const ClipWindow&) const;
         // 處理斜率為負的線段
-        void rasterizeLineInNegativeSlope(const std::pair<int, int>&, const std::pair<int, int>&, const int&, const int&, const bool&) const;
+        void rasterizeLineInNegativeSlope(const std::pair<int, int>&, const std::pair<int, int>&, const int&, const int&, const bool&, const ClipWindow&) const;
+    };
+
+    // 以畫格子 callback 建立演算法
+    using Factory = std::function<std::unique_ptr<Algorithm>(const Callback&)>;
+
+    // 演算法實作需要的指令集
+    enum class InstructionSet
+    {
+        Generic,
+        Sse2,
+        Avx2,
+        Neon
+    };
+
+    // 演算法適合的斜率
+    enum class SlopePreference
+    {
+        Any,
+        Shallow,
+        Steep
+    };
+
+    struct CpuFeatures
+    {
+        bool hasSse2;
+        bool hasAvx2;
+        bool hasNeon;
+
+        /// <summary>
+        /// 偵測目前 CPU 支援的指令集
+        /// </summary>
+        /// <returns></returns>
+        static CpuFeatures detect();
+
+        bool supports(InstructionSet instructionSet) const;
+        std::string toString() const;
+    };
+
+    struct Capabilities
+    {
+        InstructionSet instructionSet;
+        // 適合的平均線段長度範圍 (格子數)
+        double minPreferredLength;
+        double maxPreferredLength;
+        SlopePreference slopePreference;
+    };
+
+    struct BatchStatistics
+    {
+        size_t count;
+        // 平均長度 (格子數)
+        double meanLength;
+        // 斜率絕對值大於 1 的線段比例
+        double steepRatio;
+
+        /// <summary>
+        /// 統計一批線段的長度與斜率
+        /// </summary>
+        /// <param name="segments"></param>
+        /// <returns></returns>
+        static BatchStatistics measure(const std::vector<Segment>& segments);
+    };
+
+    class Registry
+    {
+    public:
+        explicit Registry(const CpuFeatures& features);
+
+        /// <summary>
+        /// 註冊演算法，名稱與是否反鋸齒取自建立出的演算法
+        /// </summary>
+        /// <param name="capabilities"></param>
+        /// <param name="factory"></param>
+        void add(const Capabilities& capabilities, const Factory& factory);
+
+        size_t size() const;
+        const CpuFeatures& getFeatures() const;
+        const std::string& getName(size_t index) const;
+        bool isAntiAliased(size_t index) const;
+        const Capabilities& getCapabilities(size_t index) const;
+
+        /// <summary>
+        /// 目前的 CPU 是否能執行此演算法
+        /// </summary>
+        /// <param name="index"></param>
+        /// <returns></returns>
+        bool isSupported(size_t index) const;
+
+        /// <summary>
+        /// 以名稱找出演算法
+        /// </summary>
+        /// <param name="name"></param>
+        /// <param name="index"></param>
+        /// <returns>是否有此演算法</returns>
+        bool find(const std::string& name, size_t& index) const;
+
+        /// <summary>
+        /// 依照 CPU 與這批線段的統計，選出最適合且反鋸齒與否相符的演算法
+        /// </summary>
+        /// <param name="isAntiAliased"></param>
+        /// <param name="segments"></param>
+        /// <param name="index"></param>
+        /// <returns>是否有反鋸齒與否相符且 CPU 支援的演算法</returns>
+        bool select(bool isAntiAliased, const std::vector<Segment>& segments, size_t& index) const;
+
+        /// <summary>
+        /// 依註冊順序建立所有演算法
+        /// </summary>
+        /// <param name="setPixel"></param>
+        /// <returns></returns>
+        std::vector<std::unique_ptr<Algorithm>> createAll(const Callback& setPixel) const;
+    private:
+        struct Entry
+        {
+            std::string name;
+            bool isAntiAliased;
+            Capabilities capabilities;
+            Factory factory;
+        };
+
+        CpuFeatures _features;
+        std::vector<Entry> _entries;
     };
 }
\ No newline at end of file
@@ -6,14 +6,26 @@
 #include <string>
 #include <functional>
 #include <utility>
+#include <memory>
+#include <map>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include <thread>
+#include <stdexcept>
 #include <GL/freeglut.h>
 
 #include "Algorithms.h"
+#include "rendering.h"
+#include "server.h"
 
 #define GET_SIGN(NUM) std::signbit(NUM) ? -1 : 1
 
 constexpr char ALGORITHM_MENU_NAME[] = "Algorithm";
 constexpr char GRID_SIZE_MENU_NAME[] = "Grid Size";
+//  CPU PCuq۰ʿܺtk
+constexpr char AUTO_ALGORITHM_NAME[] = "auto";
+constexpr char AUTO_ANTI_ALIASING_ALGORITHM_NAME[] = "auto-anti-aliasing";
 
 constexpr float GRID_LINE_WIDTH = 1.5f;
 constexpr float LINE_WIDTH = 1.8f;
@@ -24,25 +36,71 @@ constexpr int WINDOW_HEIGHT = 600;
 constexpr double CELL_WIDTH = 1.0;
 constexpr double CELL_HALF_WIDTH = CELL_WIDTH / 2;
 
+// ]ƵGb Grid ~h[\lơAݥ]tϿhe@
+constexpr int COVERAGE_MARGIN = 2;
+// ˬd worker thread O_sej (ms)
+constexpr unsigned int FRAME_POLL_INTERVAL = 16;
+// uqŶިC bucket l
+constexpr int SEGMENT_INDEX_BUCKET_SIZE = 8;
+// Iuqɤ\Z
+constexpr double PICK_TOLERANCE = CELL_WIDTH;
+// CY񪺭v
+constexpr double ZOOM_STEP = 1.25;
+// j̤jɵeܤܪl
+constexpr double MIN_VISIBLE_CELLS = 4.0;
+// Ceeת
+constexpr double PAN_STEP = 0.1;
+// lp󦹹Ʈɤeu
+constexpr double MIN_GRID_LINE_SPACING = 4.0;
+// HrLX render server GɡA̳zץѲH@ϥΪr
+constexpr char COVERAGE_SHADES[] = " .:-=+*#%@";
+
+// uq_IPI (World y)
+using Line = std::pair<std::pair<double, double>, std::pair<double, double>>;
+
 // precompile
+void registerAlgorithms();
+void initializeAlgorithms();
+void initializeRasterWorker();
+bool selectAlgorithm(const std::string&);
+int runRenderServer(const std::string&);
+int runRenderClient(int, char **);
+
 void changeSize(int, int);
 void renderScene();
 
 void handleMouseOnLeftClickUp();
 void handleMouseOnLeftClickDown(int, int);
+void handleMouseOnMiddleClickDown(int, int);
 void handleMouseEvent(int, int, int, int);
 void handleMouseMotionEvent(int, int);
 void handleKeyboardEvent(unsigned char, int, int);
+void handleSpecialKeyEvent(int, int, int);
 void handleAlgorithmMenuOnSelect(int);
 void handleGridSizeMenuOnSelect(int);
+void handleFramePollTimer(int);
 
 void setUpRC();
 void buildPopupMenu();
 void drawLines();
-void rasterizingLines();
+void drawPixels(const Rendering::CoveragePyramid&);
+void rasterizingLines(const Rendering::Rect&);
+
+void addLine(const std::pair<double, double>&, const std::pair<double, double>&);
+void removeLine(size_t);
+void moveLine(size_t, double, double);
+bool pickLine(const std::pair<double, double>&, size_t&);
 
 double getGridBoundary();
+double getViewHalfWidth();
+int selectPyramidLevel(const Rendering::CoveragePyramid&);
+void zoomView(double);
+void panView(double, double);
+void resetView();
 void clearState();
+Rendering::Rect getCoverageArea();
+Rendering::Segment convertLineToSegment(const Line&);
+double getDistanceToLine(const std::pair<double, double>&, const Line&);
 std::pair<double, double> convertWindowCoordinateToWorldCoordinate(const int&, const int&);
 void printMouseMessage(const double&, const double&);
 int roundToInt(const double& value);
@@ -50,9 +108,26 @@ int roundToInt(const double& value);
 // Shared variables
 // ثeܪtk
 Algorithms::Algorithm *selectedAlgorithm;
+// O_ registry ̨CuqܺtkAHέnܤϿΫDϿtk
+bool isAutoAlgorithm;
+bool isAutoAntiAliased;
 int gridSize;
-// ƹIFǮyI
-std::vector<std::pair<double, double>> selectedPoints;
+// wenuqAH id ƧǧY[J
+std::map<size_t, Line> lines;
+size_t nextLineId;
+// Hldd߽uqAdH Grid Size إ
+std::unique_ptr<Rendering::SegmentIndex> segmentIndex;
+// ƹuq
+bool hasSelectedLine;
+size_t selectedLineId;
+// weX٨ST{edAu@Qɭn֤JU@
+Rendering::Rect pendingArea = Rendering::Rect::empty();
+unsigned long long submittedGeneration;
+
+// Y񭿲vA1 ܾ Grid
+double zoom;
+// e (World y)
+std::pair<double, double> viewCenter;
 
 bool isDragging;
 double mouseX;
@@ -62,10 +137,14 @@ std::pair<double, double> startMousePoint;
 // ƹUI
 std::pair<double, double> endMousePoint;
 
-// Algorithm menu options
+// ҦiΪtkPS
+Algorithms::Registry registry(Algorithms::CpuFeatures::detect());
+// Algorithm menu optionsAǻP registry ۦP
 std::vector<std::unique_ptr<Algorithms::Algorithm>> algorithms;
 // Grid size menu options
-const std::array<int, 5> GRID_SIZES = {10, 15, 20, 25, 30};
+const std::array<int, 8> GRID_SIZES = {10, 15, 20, 25, 30, 100, 500, 1000};
+// bIi]ơAubҦU Grid Size إߡFݦb algorithms ŧiHK thread
+std::unique_ptr<Rendering::RasterWorker> rasterWorker;
 
 // Light values and coordinates
 const std::array<GLfloat, 4> ENV_AMBIENT_COLOR = {0.45f, 0.45f, 0.45f, 1.0f};
@@ -73,41 +152,133 @@ const std::array<GLfloat, 4> SOURCE_COLOR = {0.25f, 0.25f, 0.25f, 1.0f};
 const std::array<GLfloat, 4> LIGHT_POSITION = {0.f, 25.0f, 20.0f, 0.0f};
 
 /// <summary>
-/// lƺtk
+/// lƺtkAsإ߮ɫOd쥻ܪtk
 /// </summary>
 void initializeAlgorithms()
 {
-    // Lambda: wqpel
-    Algorithms::Callback setPixel = [](double centerX, double centerY, double alpha)
+    // tku|b worker thread WAe back buffer
+    Algorithms::Callback setPixel = rasterWorker->getPixelWriter();
+
+    size_t selectedIndex = 0;
+    for (size_t i = 0; i < algorithms.size(); i++)
     {
-        std::cout << "Drawing pixel (" << centerX << "," << centerY << ")" << std::endl;
+        if (algorithms[i].get() == selectedAlgorithm)
+        {
+            selectedIndex = i;
+        }
+    }
+    algorithms = registry.createAll(setPixel);
+    selectedAlgorithm = algorithms[selectedIndex].get();
+}
+
+/// <summary>
+/// ̷ Grid Size إ worker thread Puqިå[JwuqAݭeӽd
+/// </summary>
+void initializeRasterWorker()
+{
+    const int extent = gridSize + COVERAGE_MARGIN;
 
-        glColor4d(0.5, 0.5, 0.5, alpha);
-        glBegin(GL_QUADS);
-        const double&& topY = centerY + CELL_HALF_WIDTH;
-        const double&& bottomY = centerY - CELL_HALF_WIDTH;
-        const double&& leftX = centerX - CELL_HALF_WIDTH;
-        const double&& rightX = centerX + CELL_HALF_WIDTH;
+    // ª worker thread i٦bϥªtkAݥ
+    rasterWorker.reset();
+    rasterWorker = std::make_unique<Rendering::RasterWorker>(extent);
+    initializeAlgorithms();
 
-        glVertex2d(leftX, topY);
-        glVertex2d(rightX, topY);
-        glVertex2d(rightX, bottomY);
-        glVertex2d(leftX, bottomY);
-        glEnd();
-    };
+    segmentIndex = std::make_unique<Rendering::SegmentIndex>(extent, SEGMENT_INDEX_BUCKET_SIZE);
+    for (const auto& line : lines)
+    {
+        segmentIndex->insert(line.first, Rendering::Rect::bounding(convertLineToSegment(line.second)));
+    }
+
+    submittedGeneration = 0;
+    pendingArea = Rendering::Rect::empty();
+    rasterWorker->start();
+}
+
+/// <summary>
+/// UtkAǧYP render server tks
+/// </summary>
+void registerAlgorithms()
+{
+    const double anyLength = std::numeric_limits<double>::max();
+    registry.add(
+        Algorithms::Capabilities{Algorithms::InstructionSet::Generic, 0.0, anyLength, Algorithms::SlopePreference::Any},
+        [](const Algorithms::Callback& setPixel) { return std::make_unique<Algorithms::MidPointAlgorithm>(setPixel); });
+    registry.add(
+        Algorithms::Capabilities{Algorithms::InstructionSet::Generic, 0.0, anyLength, Algorithms::SlopePreference::Any},
+        [](const Algorithms::Callback& setPixel) { return std::make_unique<Algorithms::AntiAliasingAlgorithm>(setPixel); });
+}
+
+/// <summary>
+/// HWٿܺtkAiϥ auto  auto-anti-aliasing
+/// </summary>
+/// <param name="name"></param>
+/// <returns>O_tkB CPU 䴩</returns>
+bool selectAlgorithm(const std::string& name)
+{
+    size_t index;
+    if (name == AUTO_ALGORITHM_NAME || name == AUTO_ANTI_ALIASING_ALGORITHM_NAME)
+    {
+        // T{۲ťB CPU 䴩tkAYuq藍ɪuΦtk
+        const bool isAntiAliased = name == AUTO_ANTI_ALIASING_ALGORITHM_NAME;
+        if (!registry.select(isAntiAliased, {}, index))
+        {
+            return false;
+        }
+        isAutoAlgorithm = true;
+        isAutoAntiAliased = isAntiAliased;
+        selectedAlgorithm = algorithms[index].get();
+    }
+    else if (registry.find(name, index) && registry.isSupported(index))
+    {
+        isAutoAlgorithm = false;
+        selectedAlgorithm = algorithms[index].get();
+    }
+    else
+    {
+        return false;
+    }
 
-    auto midpoint = std::make_unique<Algorithms::MidPointAlgorithm>(setPixel);
-    algorithms.push_back(std::move(midpoint));
-    auto antiAliasing = std::make_unique<Algorithms::AntiAliasingAlgorithm>(setPixel);
-    algorithms.push_back(std::move(antiAliasing));
+    std::cout << "Change to use " << name << " algorithm" << std::endl;
+    return true;
 }
 
 int main(int argc, char **argv)
 {
-    initializeAlgorithms();
+    registerAlgorithms();
+
+    // main --serve <socket>: H render server ҦA}ҵ
+    if (argc >= 3 && std::string(argv[1]) == "--serve")
+    {
+        return runRenderServer(argv[2]);
+    }
+
+    // main --request <socket> <algorithm> x0 y0 x1 y1 ...: eXuq render server æLXG
+    if (argc >= 4 && std::string(argv[1]) == "--request")
+    {
+        return runRenderClient(argc, argv);
+    }
+
+    std::cout << "CPU features: " << registry.getFeatures().toString() << std::endl;
+
     isDragging = false;
-    selectedAlgorithm = algorithms.front().get();
+    hasSelectedLine = false;
+    nextLineId = 0;
+    isAutoAlgorithm = false;
+    isAutoAntiAliased = false;
     gridSize = GRID_SIZES.front();
+    initializeRasterWorker();
+
+    // main --algorithm <name>: w@}lϥΪtk
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (std::string(argv[i]) == "--algorithm" && !selectAlgorithm(argv[i + 1]))
+        {
+            std::cerr << "Unknown or unsupported algorithm " << argv[i + 1] << std::endl;
+            return 1;
+        }
+    }
+    rasterizingLines(getCoverageArea());
+    resetView();
 
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
@@ -123,11 +294,105 @@ int main(int argc, char **argv)
     glutMouseFunc(handleMouseEvent);
     glutPassiveMotionFunc(handleMouseMotionEvent);
     glutKeyboardFunc(handleKeyboardEvent);
+    glutSpecialFunc(handleSpecialKeyEvent);
+    glutTimerFunc(FRAME_POLL_INTERVAL, handleFramePollTimer, 0);
 
     glutMainLoop(); // http://www.programmer-club.com.tw/ShowSameTitleN/opengl/2288.html
     return 0;
 }
 
+/// <summary>
+/// H render server ҦA process 
+/// </summary>
+/// <param name="socketPath"></param>
+/// <returns></returns>
+int runRenderServer(const std::string& socketPath)
+{
+    try
+    {
+        Server::RenderServer server(socketPath, registry, std::thread::hardware_concurrency());
+        std::cout << "CPU features: " << registry.getFeatures().toString() << std::endl;
+        std::cout << "Render server listening on " << socketPath << std::endl;
+        server.run();
+    }
+    catch (const std::runtime_error& error)
+    {
+        std::cerr << "Render server error: " << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/// <summary>
+/// eXROCWuq render serverAåHrLX]ƵG
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int runRenderClient(int argc, char **argv)
+{
+    try
+    {
+        // tkiHΦW٩νsw
+        const std::string name = argv[3];
+        uint32_t algorithm = 0;
+        size_t index;
+        if (name == AUTO_ALGORITHM_NAME)
+        {
+            algorithm = Server::ALGORITHM_AUTO;
+        }
+        else if (name == AUTO_ANTI_ALIASING_ALGORITHM_NAME)
+        {
+            algorithm = Server::ALGORITHM_AUTO_ANTI_ALIASING;
+        }
+        else if (registry.find(name, index))
+        {
+            algorithm = static_cast<uint32_t>(index);
+        }
+        else if (!name.empty() && name.find_first_not_of("0123456789") == std::string::npos)
+        {
+            algorithm = static_cast<uint32_t>(std::stoul(name));
+        }
+        else
+        {
+            std::cerr << "Unknown algorithm " << name << std::endl;
+            return 1;
+        }
+
+        if ((argc - 4) % 4 != 0)
+        {
+            throw std::invalid_argument("each segment needs x0 y0 x1 y1");
+        }
+        std::vector<Rendering::Segment> segments;
+        for (int i = 4; i < argc; i += 4)
+        {
+            segments.emplace_back(std::make_pair(std::stoi(argv[i]), std::stoi(argv[i + 1])), std::make_pair(std::stoi(argv[i + 2]), std::stoi(argv[i + 3])));
+        }
+
+        Server::RenderClient client(argv[2]);
+        std::vector<uint8_t> coverage;
+        const Server::ResponseHeader response = client.render(algorithm, segments, coverage);
+        std::cout << "Status " << response.status << ", cells (" << response.left << "," << response.bottom << ") - (" << response.right << "," << response.top << "), " << response.drawnCount << " drawn" << std::endl;
+
+        const int width = response.right - response.left + 1;
+        for (int row = response.top - response.bottom; !coverage.empty() && row >= 0; row--)
+        {
+            for (int column = 0; column < width; column++)
+            {
+                const uint8_t alpha = coverage[static_cast<size_t>(row) * width + column];
+                std::cout << COVERAGE_SHADES[alpha * (sizeof(COVERAGE_SHADES) - 2) / 255];
+            }
+            std::cout << std::endl;
+        }
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "Render request failed: " << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
 /// <summary>
 /// Bzƹʨƥ
 /// </summary>
@@ -154,7 +419,18 @@ void handleMouseMotionEvent(int x, int y)
 /// <param name="y"></param>
 void handleMouseEvent(int button, int state, int x, int y)
 {
-    if (button == GLUT_LEFT_BUTTON)
+    if (button == GLUT_MIDDLE_BUTTON && state == GLUT_DOWN)
+    {
+        handleMouseOnMiddleClickDown(x, y);
+        glutPostRedisplay();
+    }
+    // freeglut Nu^ 3B4 ӫ
+    else if ((button == 3 || button == 4) && state == GLUT_DOWN)
+    {
+        zoomView(button == 3 ? ZOOM_STEP : 1.0 / ZOOM_STEP);
+        glutPostRedisplay();
+    }
+    else if (button == GLUT_LEFT_BUTTON)
     {
         switch (state)
         {
@@ -184,6 +460,63 @@ void handleKeyboardEvent(unsigned char key, int, int)
     {
         clearState();
     }
+    // Delete  Backspace Ruq
+    else if ((key == 127 || key == '\b') && hasSelectedLine)
+    {
+        removeLine(selectedLineId);
+        hasSelectedLine = false;
+    }
+    else if (key == '+' || key == '=')
+    {
+        zoomView(ZOOM_STEP);
+    }
+    else if (key == '-')
+    {
+        zoomView(1.0 / ZOOM_STEP);
+    }
+    else if (key == '0')
+    {
+        resetView();
+    }
+    else if (key == 'w' || key == 'a' || key == 's' || key == 'd')
+    {
+        const double step = 2.0 * getViewHalfWidth() * PAN_STEP;
+        panView(key == 'a' ? -step : key == 'd' ? step : 0.0, key == 's' ? -step : key == 'w' ? step : 0.0);
+    }
+
+    glutPostRedisplay();
+}
+
+/// <summary>
+/// BzSƥAV䲾ʿuq
+/// </summary>
+/// <param name="key"></param>
+/// <param name=""></param>
+/// <param name=""></param>
+void handleSpecialKeyEvent(int key, int, int)
+{
+    if (!hasSelectedLine)
+    {
+        return;
+    }
+
+    switch (key)
+    {
+    case GLUT_KEY_UP:
+        moveLine(selectedLineId, 0.0, CELL_WIDTH);
+        break;
+    case GLUT_KEY_DOWN:
+        moveLine(selectedLineId, 0.0, -CELL_WIDTH);
+        break;
+    case GLUT_KEY_LEFT:
+        moveLine(selectedLineId, -CELL_WIDTH, 0.0);
+        break;
+    case GLUT_KEY_RIGHT:
+        moveLine(selectedLineId, CELL_WIDTH, 0.0);
+        break;
+    default:
+        return;
+    }
 
     glutPostRedisplay();
 }
@@ -195,9 +528,28 @@ void handleKeyboardEvent(unsigned char key, int, int)
 void handleAlgorithmMenuOnSelect(int index)
 {
     isDragging = false;
-    // QΦhܺtkèϥ
-    selectedAlgorithm = algorithms[index].get();
-    std::cout << "Change to use " << selectedAlgorithm->getName() << " algorithm" << std::endl;
+    // ̫ӿﶵ۰ʿ
+    const size_t count = registry.size();
+    std::string name;
+    if (static_cast<size_t>(index) == count)
+    {
+        name = AUTO_ALGORITHM_NAME;
+    }
+    else if (static_cast<size_t>(index) == count + 1)
+    {
+        name = AUTO_ANTI_ALIASING_ALGORITHM_NAME;
+    }
+    else
+    {
+        name = registry.getName(index);
+    }
+    // ثe CPU 䴩ɫOd쥻tk
+    if (!selectAlgorithm(name))
+    {
+        std::cout << "Algorithm " << name << " is not supported on this CPU" << std::endl;
+        return;
+    }
+    rasterizingLines(getCoverageArea());
     glutPostRedisplay();
 }
 
@@ -209,25 +561,178 @@ void handleGridSizeMenuOnSelect(int size)
 {
     isDragging = false;
     gridSize = size;
+    initializeRasterWorker();
+    rasterizingLines(getCoverageArea());
+    resetView();
     std::cout << "Change grid size to " << size << std::endl;
     glutPostRedisplay();
 }
 
 /// <summary>
-/// ̷өҿotki]
+/// pɾ - ˬd worker thread O_se
 /// </summary>
-void rasterizingLines()
+/// <param name=""></param>
+void handleFramePollTimer(int)
 {
-    for (auto firstIter = selectedPoints.begin(); firstIter != selectedPoints.end(); firstIter += 2)
+    if (rasterWorker->hasNewFrame())
     {
-        auto secondIter = firstIter + 1;
+        glutPostRedisplay();
+    }
+    glutTimerFunc(FRAME_POLL_INTERVAL, handleFramePollTimer, 0);
+}
+
+/// <summary>
+/// ̷өҿotks] area lA浹 worker thread Bz
+/// </summary>
+/// <param name="area"></param>
+void rasterizingLines(const Rendering::Rect& area)
+{
+    if (rasterWorker->getCompletedGeneration() == submittedGeneration)
+    {
+        pendingArea = area;
+    }
+    else
+    {
+        pendingArea = pendingArea.united(area);
+    }
+
+    // uݭnPed|uq
+    std::vector<Rendering::Segment> segments;
+    for (const size_t& id : segmentIndex->query(pendingArea))
+    {
+        segments.push_back(convertLineToSegment(lines.at(id)));
+    }
+
+    // ϥΦtkA۰ʼҦUCuqsܡA藍ɪuΤ۰ʼҦɿXtk
+    const Algorithms::Algorithm* algorithm = selectedAlgorithm;
+    size_t index;
+    if (isAutoAlgorithm && registry.select(isAutoAntiAliased, segments, index))
+    {
+        algorithm = algorithms[index].get();
+    }
+    submittedGeneration = rasterWorker->submit(segments, algorithm, pendingArea);
+}
+
+/// <summary>
+/// [Juqíe[\l
+/// </summary>
+/// <param name="startPoint"></param>
+/// <param name="endPoint"></param>
+void addLine(const std::pair<double, double>& startPoint, const std::pair<double, double>& endPoint)
+{
+    const size_t id = nextLineId++;
+    const Line line(startPoint, endPoint);
+    const Rendering::Rect bounds = Rendering::Rect::bounding(convertLineToSegment(line));
+
+    lines.emplace(id, line);
+    segmentIndex->insert(id, bounds);
+    rasterizingLines(bounds);
+}
+
+/// <summary>
+/// uqíe쥻[\l
+/// </summary>
+/// <param name="id"></param>
+void removeLine(size_t id)
+{
+    const Rendering::Rect bounds = Rendering::Rect::bounding(convertLineToSegment(lines.at(id)));
+
+    lines.erase(id);
+    segmentIndex->remove(id);
+    std::cout << "Remove line " << id << std::endl;
+    rasterizingLines(bounds);
+}
+
+/// <summary>
+/// uqíeʫe[\l
+/// </summary>
+/// <param name="id"></param>
+/// <param name="dx"></param>
+/// <param name="dy"></param>
+void moveLine(size_t id, double dx, double dy)
+{
+    Line& line = lines.at(id);
+    const Rendering::Rect oldBounds = Rendering::Rect::bounding(convertLineToSegment(line));
 
-        auto startPoint = std::make_pair<int, int>(roundToInt(firstIter->first), roundToInt(firstIter->second));
-        auto endPoint = std::make_pair<int, int>(roundToInt(secondIter->first), roundToInt(secondIter->second));
+    line.first.first += dx;
+    line.first.second += dy;
+    line.second.first += dx;
+    line.second.second += dy;
+    const Rendering::Rect newBounds = Rendering::Rect::bounding(convertLineToSegment(line));
 
-        // ϥΦtk
-        selectedAlgorithm->apply(startPoint, endPoint);
+    segmentIndex->remove(id);
+    segmentIndex->insert(id, newBounds);
+    rasterizingLines(oldBounds.united(newBounds));
+}
+
+/// <summary>
+/// X̾a point uq
+/// </summary>
+/// <param name="point"></param>
+/// <param name="id"></param>
+/// <returns>O_uqb PICK_TOLERANCE </returns>
+bool pickLine(const std::pair<double, double>& point, size_t& id)
+{
+    double minDistance = std::numeric_limits<double>::max();
+    // uqldwhd@Auݬd߷ƹҦbl
+    for (const size_t& candidate : segmentIndex->query(roundToInt(point.first), roundToInt(point.second)))
+    {
+        const double distance = getDistanceToLine(point, lines.at(candidate));
+        if (distance < minDistance)
+        {
+            minDistance = distance;
+            id = candidate;
+        }
+    }
+    return minDistance <= PICK_TOLERANCE;
+}
+
+/// <summary>
+/// eX]ƧlAueelèY pyramid h
+/// </summary>
+/// <param name="frame"></param>
+void drawPixels(const Rendering::CoveragePyramid& frame)
+{
+    const int extent = frame.getExtent();
+    const int level = selectPyramidLevel(frame);
+    const int span = 1 << level;
+    const double halfWidth = getViewHalfWidth();
+
+    // ed򴫺⦨ 0 hޫAA⦨h
+    const auto toLevelIndex = [&](double world)
+    {
+        const int index = static_cast<int>(std::floor(world + CELL_HALF_WIDTH)) + extent;
+        return std::min(std::max(index, 0), 2 * extent) >> level;
+    };
+    const int firstColumn = toLevelIndex(viewCenter.first - halfWidth);
+    const int lastColumn = toLevelIndex(viewCenter.first + halfWidth);
+    const int firstRow = toLevelIndex(viewCenter.second - halfWidth);
+    const int lastRow = toLevelIndex(viewCenter.second + halfWidth);
+
+    glBegin(GL_QUADS);
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        for (int column = firstColumn; column <= lastColumn; column++)
+        {
+            const double alpha = frame.getAlpha(level, column, row);
+            if (alpha <= 0.0)
+            {
+                continue;
+            }
+
+            glColor4d(0.5, 0.5, 0.5, alpha);
+            const double&& bottomY = row * span - extent - CELL_HALF_WIDTH;
+            const double&& topY = bottomY + span * CELL_WIDTH;
+            const double&& leftX = column * span - extent - CELL_HALF_WIDTH;
+            const double&& rightX = leftX + span * CELL_WIDTH;
+
+            glVertex2d(leftX, topY);
+            glVertex2d(rightX, topY);
+            glVertex2d(rightX, bottomY);
+            glVertex2d(leftX, bottomY);
+        }
     }
+    glEnd();
 }
 
 /// <summary>
@@ -238,13 +743,24 @@ void drawLines()
     glColor3d(0.0, 0.0, 1.0);
     glLineWidth(LINE_WIDTH);
     glBegin(GL_LINES);
-    for (auto iter = selectedPoints.begin(); iter != selectedPoints.end(); iter += 2)
+    for (const auto& iter : lines)
     {
-        glVertex2d(iter->first, iter->second);
-        glVertex2d((iter + 1)->first, (iter + 1)->second);
+        const Line& line = iter.second;
+        glVertex2d(line.first.first, line.first.second);
+        glVertex2d(line.second.first, line.second.second);
     }
     glEnd();
 
+    if (hasSelectedLine)
+    {
+        const Line& line = lines.at(selectedLineId);
+        glColor3d(0.0, 0.8, 0.0);
+        glBegin(GL_LINES);
+        glVertex2d(line.first.first, line.first.second);
+        glVertex2d(line.second.first, line.second.second);
+        glEnd();
+    }
+
     if (isDragging)
     {
         glColor3d(1.0, 0.0, 0.0);
@@ -260,16 +776,32 @@ void drawLines()
 /// </summary>
 void drawGrid()
 {
+    const double halfWidth = getViewHalfWidth();
+    // lӤpɮu|\e
+    if (WINDOW_WIDTH / (2.0 * halfWidth) < MIN_GRID_LINE_SPACING)
+    {
+        return;
+    }
+
+    // ueeuAu -boundary + i
+    const double boundary = getGridBoundary();
+    const double left = std::max(viewCenter.first - halfWidth, -boundary);
+    const double right = std::min(viewCenter.first + halfWidth, boundary);
+    const double bottom = std::max(viewCenter.second - halfWidth, -boundary);
+    const double top = std::min(viewCenter.second + halfWidth, boundary);
+
     glColor3d(0.0, 0.0, 0.0);
     glLineWidth(GRID_LINE_WIDTH);
     glBegin(GL_LINES);
-    const double boundary = getGridBoundary();
-    for (double i = -boundary; i <= boundary; i++)
+    for (double i = -boundary + std::ceil(left + boundary); i <= right; i++)
+    {
+        glVertex2d(i, bottom);
+        glVertex2d(i, top);
+    }
+    for (double i = -boundary + std::ceil(bottom + boundary); i <= top; i++)
     {
-        glVertex2d(-boundary, i);
-        glVertex2d(boundary, i);
-        glVertex2d(i, boundary);
-        glVertex2d(i, -boundary);
+        glVertex2d(left, i);
+        glVertex2d(right, i);
     }
     glEnd();
 }
@@ -283,13 +815,13 @@ void renderScene()
     glClear(GL_COLOR_BUFFER_BIT);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    const double boundary = getGridBoundary();
-    glOrtho(-boundary, boundary, -boundary, boundary, -10.0, 30.0);
+    const double halfWidth = getViewHalfWidth();
+    glOrtho(viewCenter.first - halfWidth, viewCenter.first + halfWidth, viewCenter.second - halfWidth, viewCenter.second + halfWidth, -10.0, 30.0);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
     gluLookAt(0.0, 0.0, 5.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0);
 
-    rasterizingLines();
+    drawPixels(rasterWorker->acquireFrame());
     drawGrid();
     drawLines();
 
@@ -304,10 +836,9 @@ void handleMouseOnLeftClickUp()
 {
     if (isDragging)
     {
-        selectedPoints.push_back(startMousePoint);
-        selectedPoints.push_back(endMousePoint);
         printMouseMessage(endMousePoint.first, endMousePoint.second);
         isDragging = false;
+        addLine(startMousePoint, endMousePoint);
     }
     else
     {
@@ -335,6 +866,21 @@ void handleMouseOnLeftClickDown(int x, int y)
     }
 }
 
+/// <summary>
+/// BzUɪƥA̾a񪺽uq
+/// </summary>
+/// <param name="x"></param>
+/// <param name="y"></param>
+void handleMouseOnMiddleClickDown(int x, int y)
+{
+    const auto point = convertWindowCoordinateToWorldCoordinate(x, y);
+    hasSelectedLine = pickLine(point, selectedLineId);
+    if (hasSelectedLine)
+    {
+        std::cout << "Select line " << selectedLineId << std::endl;
+    }
+}
+
 /// <summary>
 /// غc menu
 /// </summary>
@@ -342,10 +888,17 @@ void buildPopupMenu()
 {
     const int algorithmMenu = glutCreateMenu(handleAlgorithmMenuOnSelect);
     int counter = 0;
-    for (size_t i = 0; i < algorithms.size(); i++, counter++)
+    for (size_t i = 0; i < registry.size(); i++, counter++)
     {
-        glutAddMenuEntry(algorithms[i]->getName().c_str(), counter);
+        std::string label = registry.getName(i);
+        if (!registry.isSupported(i))
+        {
+            label += " (unsupported)";
+        }
+        glutAddMenuEntry(label.c_str(), counter);
     }
+    glutAddMenuEntry(AUTO_ALGORITHM_NAME, counter++);
+    glutAddMenuEntry(AUTO_ANTI_ALIASING_ALGORITHM_NAME, counter++);
 
     const int gridSizeMenu = glutCreateMenu(handleGridSizeMenuOnSelect);
     for (const int &size : GRID_SIZES)
@@ -396,13 +949,119 @@ double getGridBoundary()
     return static_cast<double>(gridSize) + CELL_HALF_WIDTH;
 }
 
+/// <summary>
+/// oeeת@b (World y)
+/// </summary>
+/// <returns></returns>
+double getViewHalfWidth()
+{
+    return getGridBoundary() / zoom;
+}
+
+/// <summary>
+/// ܨCӹ̦h@Ӯl̲ӼhšAXlƤ|WL
+/// </summary>
+/// <param name="frame"></param>
+/// <returns></returns>
+int selectPyramidLevel(const Rendering::CoveragePyramid& frame)
+{
+    const double cellsPerPixel = 2.0 * getViewHalfWidth() / WINDOW_WIDTH;
+    int level = 0;
+    while (level + 1 < frame.getLevelCount() && (1 << level) < cellsPerPixel)
+    {
+        level++;
+    }
+    return level;
+}
+
+/// <summary>
+/// H factor vYeA|YpWL Grid
+/// </summary>
+/// <param name="factor"></param>
+void zoomView(double factor)
+{
+    const double maxZoom = std::max(1.0, getGridBoundary() / MIN_VISIBLE_CELLS);
+    zoom = std::min(std::max(zoom * factor, 1.0), maxZoom);
+    panView(0.0, 0.0);
+}
+
+/// <summary>
+/// eAeߤ|WX Grid
+/// </summary>
+/// <param name="dx"></param>
+/// <param name="dy"></param>
+void panView(double dx, double dy)
+{
+    const double boundary = getGridBoundary();
+    viewCenter.first = std::min(std::max(viewCenter.first + dx, -boundary), boundary);
+    viewCenter.second = std::min(std::max(viewCenter.second + dy, -boundary), boundary);
+}
+
+/// <summary>
+/// ^ܾ Grid
+/// </summary>
+void resetView()
+{
+    zoom = 1.0;
+    viewCenter = std::make_pair(0.0, 0.0);
+}
+
 /// <summary>
 /// MA
 /// </summary>
 void clearState()
 {
     isDragging = false;
-    selectedPoints.clear();
+    hasSelectedLine = false;
+    lines.clear();
+    segmentIndex->clear();
+    rasterizingLines(getCoverageArea());
+}
+
+/// <summary>
+/// o]ƵG[\Ҧl
+/// </summary>
+/// <returns></returns>
+Rendering::Rect getCoverageArea()
+{
+    const int extent = gridSize + COVERAGE_MARGIN;
+    return Rendering::Rect{-extent, -extent, extent, extent};
+}
+
+/// <summary>
+/// NuqI|ˤJly
+/// </summary>
+/// <param name="line"></param>
+/// <returns></returns>
+Rendering::Segment convertLineToSegment(const Line& line)
+{
+    auto startPoint = std::make_pair<int, int>(roundToInt(line.first.first), roundToInt(line.first.second));
+    auto endPoint = std::make_pair<int, int>(roundToInt(line.second.first), roundToInt(line.second.second));
+    return Rendering::Segment(startPoint, endPoint);
+}
+
+/// <summary>
+/// pIuq̵uZ
+/// </summary>
+/// <param name="point"></param>
+/// <param name="line"></param>
+/// <returns></returns>
+double getDistanceToLine(const std::pair<double, double>& point, const Line& line)
+{
+    const double dx = line.second.first - line.first.first;
+    const double dy = line.second.second - line.first.second;
+    const double lengthSquared = dx * dx + dy * dy;
+
+    double t = 0.0;
+    if (lengthSquared > 0.0)
+    {
+        t = ((point.first - line.first.first) * dx + (point.second - line.first.second) * dy) / lengthSquared;
+        t = std::min(std::max(t, 0.0), 1.0);
+    }
+
+    const double nearestX = line.first.first + t * dx;
+    const double nearestY = line.first.second + t * dy;
+    return std::hypot(point.first - nearestX, point.second - nearestY);
 }
 
 /// <summary>
@@ -413,9 +1072,9 @@ void clearState()
 /// <returns></returns>
 std::pair<double, double> convertWindowCoordinateToWorldCoordinate(const int& x, const int& y)
 {
-    const double size = getGridBoundary();
-    const double worldX = (2.0 * static_cast<double>(x) / WINDOW_WIDTH - 1.0) * size;
-    const double worldY = (1.0 - 2.0 * static_cast<double>(y) / WINDOW_HEIGHT) * size;
+    const double size = getViewHalfWidth();
+    const double worldX = viewCenter.first + (2.0 * static_cast<double>(x) / WINDOW_WIDTH - 1.0) * size;
+    const double worldY = viewCenter.second + (1.0 - 2.0 * static_cast<double>(y) / WINDOW_HEIGHT) * size;
     return std::pair<double, double>(worldX, worldY);
 }
 
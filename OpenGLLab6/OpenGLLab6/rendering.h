@@ -0,0 +1,417 @@
+﻿#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Algorithms.h"
+
+namespace Rendering
+{
+    using Segment = Algorithms::Segment;
+
+    // 格子座標的矩形範圍，上下左右皆包含在內
+    struct Rect
+    {
+        int left;
+        int bottom;
+        int right;
+        int top;
+
+        /// <summary>
+        /// 取得空的範圍
+        /// </summary>
+        /// <returns></returns>
+        static Rect empty();
+
+        /// <summary>
+        /// 取得線段光柵化後可能畫到的範圍
+        /// </summary>
+        /// <param name="segment"></param>
+        /// <returns></returns>
+        static Rect bounding(const Segment& segment);
+
+        bool isEmpty() const;
+        bool contains(int x, int y) const;
+        bool intersects(const Rect& other) const;
+        // 同時包含兩個範圍的最小範圍
+        Rect united(const Rect& other) const;
+        // 兩個範圍重疊的部分
+        Rect intersected(const Rect& other) const;
+    };
+
+    class CoverageBuffer
+    {
+    public:
+        explicit CoverageBuffer(int extent);
+
+        /// <summary>
+        /// 取得涵蓋範圍，格子座標介於 [-extent, extent]
+        /// </summary>
+        /// <returns></returns>
+        int getExtent() const;
+
+        /// <summary>
+        /// 取得格子的透明度，超出範圍回傳 0
+        /// </summary>
+        /// <param name="x"></param>
+        /// <param name="y"></param>
+        /// <returns></returns>
+        double getAlpha(int x, int y) const;
+
+        /// <summary>
+        /// 以 over 混色疊加格子的透明度，與 GL_ONE_MINUS_SRC_ALPHA 的結果相同
+        /// </summary>
+        /// <param name="x"></param>
+        /// <param name="y"></param>
+        /// <param name="alpha"></param>
+        void blend(int x, int y, double alpha);
+
+        /// <summary>
+        /// 清空所有格子
+        /// </summary>
+        void clear();
+
+        /// <summary>
+        /// 清空範圍內的格子
+        /// </summary>
+        /// <param name="area"></param>
+        void clear(const Rect& area);
+
+        /// <summary>
+        /// 從另一個相同大小的 buffer 複製範圍內的格子
+        /// </summary>
+        /// <param name="source"></param>
+        /// <param name="area"></param>
+        void copy(const CoverageBuffer& source, const Rect& area);
+
+        /// <summary>
+        /// 取得整個涵蓋範圍
+        /// </summary>
+        /// <returns></returns>
+        Rect getBounds() const;
+    private:
+        // 涵蓋範圍
+        const int _extent;
+        // 每列的格子數
+        const int _width;
+        // 每個格子的透明度
+        std::vector<float> _alpha;
+    };
+
+    class CoveragePyramid
+    {
+    public:
+        /// <summary>
+        /// 第 0 層為 [-extent, extent] 的格子，往上每層長寬減半，取 2x2 格子的平均
+        /// </summary>
+        /// <param name="extent"></param>
+        explicit CoveragePyramid(int extent);
+
+        int getExtent() const;
+        int getLevelCount() const;
+
+        /// <summary>
+        /// 取得某一層每列的格子數
+        /// </summary>
+        /// <param name="level"></param>
+        /// <returns></returns>
+        int getLevelWidth(int level) const;
+
+        /// <summary>
+        /// 取得某一層格子的透明度，column 與 row 從 0 開始，超出範圍回傳 0
+        /// </summary>
+        /// <param name="level"></param>
+        /// <param name="column"></param>
+        /// <param name="row"></param>
+        /// <returns></returns>
+        double getAlpha(int level, int column, int row) const;
+
+        /// <summary>
+        /// 疊加第 0 層格子的透明度，需呼叫 update 才會反映到上層
+        /// </summary>
+        /// <param name="x"></param>
+        /// <param name="y"></param>
+        /// <param name="alpha"></param>
+        void blend(int x, int y, double alpha);
+
+        /// <summary>
+        /// 清空第 0 層範圍內的格子
+        /// </summary>
+        /// <param name="area"></param>
+        void clear(const Rect& area);
+
+        /// <summary>
+        /// 依第 0 層重新計算上層中受 area 影響的格子
+        /// </summary>
+        /// <param name="area"></param>
+        void update(const Rect& area);
+
+        /// <summary>
+        /// 從另一個相同大小的 pyramid 複製每一層受 area 影響的格子
+        /// </summary>
+        /// <param name="source"></param>
+        /// <param name="area"></param>
+        void copy(const CoveragePyramid& source, const Rect& area);
+    private:
+        // 將第 0 層的格子範圍轉換成某一層的索引範圍
+        Rect toLevelArea(const Rect& area, int level) const;
+
+        // 第 0 層
+        CoverageBuffer _base;
+        // 第 1 層以上每層每列的格子數
+        std::vector<int> _widths;
+        // 第 1 層以上每個格子的透明度
+        std::vector<std::vector<float>> _levels;
+    };
+
+    class BitBuffer
+    {
+    public:
+        /// <summary>
+        /// 每個格子只用 1 bit 記錄是否被畫到，給沒有反鋸齒的演算法使用
+        /// </summary>
+        /// <param name="bounds"></param>
+        explicit BitBuffer(const Rect& bounds);
+
+        /// <summary>
+        /// 改變範圍並清空，盡量重複使用原本的記憶體
+        /// </summary>
+        /// <param name="bounds"></param>
+        void reset(const Rect& bounds);
+
+        const Rect& getBounds() const;
+        bool get(int x, int y) const;
+
+        /// <summary>
+        /// 畫一個格子，同一列連續的格子會先累積成一段，需呼叫 flush 寫入
+        /// </summary>
+        /// <param name="x"></param>
+        /// <param name="y"></param>
+        void plot(int x, int y);
+
+        /// <summary>
+        /// 寫入尚未寫入的一段格子
+        /// </summary>
+        void flush();
+
+        /// <summary>
+        /// 以 64 bit 為單位畫一整段水平的格子，超出範圍的部分會被忽略
+        /// </summary>
+        /// <param name="y"></param>
+        /// <param name="left"></param>
+        /// <param name="right"></param>
+        void setSpan(int y, int left, int right);
+
+        /// <summary>
+        /// 清空 area 內的格子，其餘格子保持不變
+        /// </summary>
+        /// <param name="area"></param>
+        void clear(const Rect& area);
+
+        /// <summary>
+        /// 被畫到的格子數
+        /// </summary>
+        /// <returns></returns>
+        size_t count() const;
+
+        /// <summary>
+        /// area 內被畫到的格子數
+        /// </summary>
+        /// <param name="area"></param>
+        /// <returns></returns>
+        size_t count(const Rect& area) const;
+
+        /// <summary>
+        /// 取得包含所有被畫到的格子的最小範圍
+        /// </summary>
+        /// <returns></returns>
+        Rect getOccupiedBounds() const;
+
+        /// <summary>
+        /// 將 area 內被畫到的格子以透明度 1 疊加到 pyramid 的第 0 層
+        /// </summary>
+        /// <param name="target"></param>
+        /// <param name="area"></param>
+        void resolve(CoveragePyramid& target, const Rect& area) const;
+
+        /// <summary>
+        /// 將 area 內被畫到的格子寫成 255，destination 需為已清空且與 area 相同大小的 buffer，由下往上逐列排列
+        /// </summary>
+        /// <param name="destination"></param>
+        /// <param name="area"></param>
+        void resolve(uint8_t* destination, const Rect& area) const;
+    private:
+        // 對 area 內每個被畫到的格子以座標呼叫 visit
+        template <typename Visitor>
+        void forEachSetCell(const Rect& area, Visitor visit) const;
+
+        Rect _bounds;
+        // 每列使用的 64 bit word 數
+        size_t _wordsPerRow;
+        std::vector<uint64_t> _words;
+
+        // 尚未寫入的一段格子
+        bool _hasRun;
+        int _runY;
+        int _runLeft;
+        int _runRight;
+    };
+
+    class SegmentIndex
+    {
+    public:
+        /// <summary>
+        /// 以固定大小的 bucket 切分 [-extent, extent]，超出範圍的線段歸到邊緣的 bucket
+        /// </summary>
+        /// <param name="extent"></param>
+        /// <param name="bucketSize"></param>
+        explicit SegmentIndex(int extent, int bucketSize);
+
+        /// <summary>
+        /// 加入線段的範圍
+        /// </summary>
+        /// <param name="id"></param>
+        /// <param name="bounds"></param>
+        void insert(size_t id, const Rect& bounds);
+
+        /// <summary>
+        /// 移除線段
+        /// </summary>
+        /// <param name="id"></param>
+        void remove(size_t id);
+
+        /// <summary>
+        /// 移除所有線段
+        /// </summary>
+        void clear();
+
+        /// <summary>
+        /// 查詢範圍與 area 重疊的線段
+        /// </summary>
+        /// <param name="area"></param>
+        /// <returns>依 id 排序且不重複</returns>
+        std::vector<size_t> query(const Rect& area) const;
+
+        /// <summary>
+        /// 查詢範圍包含此格子的線段
+        /// </summary>
+        /// <param name="x"></param>
+        /// <param name="y"></param>
+        /// <returns>依 id 排序且不重複</returns>
+        std::vector<size_t> query(int x, int y) const;
+    private:
+        // 格子座標轉換成 bucket 索引
+        int toBucket(int value) const;
+
+        const int _extent;
+        const int _bucketSize;
+        // 每列的 bucket 數
+        const int _bucketsPerRow;
+        // 每個 bucket 內的線段 id
+        std::vector<std::vector<size_t>> _buckets;
+        // 每個線段的範圍
+        std::unordered_map<size_t, Rect> _bounds;
+    };
+
+    class RasterWorker
+    {
+    public:
+        explicit RasterWorker(int extent);
+        ~RasterWorker();
+
+        RasterWorker(const RasterWorker&) = delete;
+        RasterWorker& operator=(const RasterWorker&) = delete;
+
+        /// <summary>
+        /// 取得給演算法使用的畫格子 callback，只會在 worker thread 上被呼叫
+        /// </summary>
+        /// <returns></returns>
+        Algorithms::Callback getPixelWriter();
+
+        /// <summary>
+        /// 啟動 worker thread
+        /// </summary>
+        void start();
+
+        /// <summary>
+        /// 送出光柵化工作，只重畫 area 內的格子，尚未完成的舊工作會被取消；
+        /// 在反鋸齒與非反鋸齒的演算法之間切換時，area 需涵蓋整個範圍
+        /// </summary>
+        /// <param name="segments">與 area 重疊的所有線段</param>
+        /// <param name="algorithm"></param>
+        /// <param name="area"></param>
+        /// <returns>此工作的編號</returns>
+        unsigned long long submit(const std::vector<Segment>& segments, const Algorithms::Algorithm* algorithm, const Rect& area);
+
+        /// <summary>
+        /// 取得最後完成的工作編號，被取消的工作不會完成
+        /// </summary>
+        /// <returns></returns>
+        unsigned long long getCompletedGeneration() const;
+
+        /// <summary>
+        /// 是否有尚未取用的完成畫面
+        /// </summary>
+        /// <returns></returns>
+        bool hasNewFrame() const;
+
+        /// <summary>
+        /// 取得最新完成的畫面，只能在 GLUT thread 上呼叫
+        /// </summary>
+        /// <returns></returns>
+        const CoveragePyramid& acquireFrame();
+    private:
+        // worker thread 主迴圈
+        void run();
+        // 交換 back buffer 與中間的 buffer
+        void publish();
+
+        // 中間 buffer 的索引遮罩
+        static constexpr unsigned int INDEX_MASK = 0x3;
+        // 中間 buffer 有新畫面的標記
+        static constexpr unsigned int FRESH_FLAG = 0x4;
+
+        // worker thread 上累積的完整結果，只有反鋸齒的演算法使用，其他時候不配置
+        std::unique_ptr<CoveragePyramid> _master;
+        // 沒有反鋸齒的演算法累積的完整結果，每個格子 1 bit，交接時直接寫入 back buffer
+        BitBuffer _bits;
+        // 目前工作的重畫範圍，範圍外的格子不寫入
+        Rect _clipArea;
+        bool _isAliasedJob;
+        // front / 中間 / back 三個 buffer，以 atomic exchange 交接不需上鎖
+        std::array<CoveragePyramid, 3> _buffers;
+        // 各個 buffer 尚未從 _master 同步的範圍，只有 worker thread 使用
+        std::array<Rect, 3> _staleAreas;
+        // GLUT thread 擁有的 buffer
+        unsigned int _frontIndex;
+        // worker thread 擁有的 buffer
+        unsigned int _backIndex;
+        // 等待交接的 buffer 與新畫面標記
+        std::atomic<unsigned int> _middle;
+
+        // 每次送出工作就遞增，用來取消過期的工作
+        std::atomic<unsigned long long> _generation;
+        // 最後完成的工作編號
+        std::atomic<unsigned long long> _completedGeneration;
+
+        std::mutex _jobMutex;
+        std::condition_variable _jobCondition;
+        // 等待處理的線段快照
+        std::vector<Segment> _pendingSegments;
+        // 等待處理的演算法
+        const Algorithms::Algorithm* _pendingAlgorithm;
+        // 等待處理的重畫範圍
+        Rect _pendingArea;
+        bool _hasPendingJob;
+        bool _isStopping;
+
+        std::thread _thread;
+    };
+}
@@ -0,0 +1,170 @@
+﻿#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Algorithms.h"
+#include "rendering.h"
+
+// 本機 render server 的二進位協定，數值皆為 host byte order
+//
+// Request:  RequestHeader, 接著 segmentCount 個 int32 x0, y0, x1, y1
+// Response: ResponseHeader, 接著 (right - left + 1) * (top - bottom + 1) 個 uint8 透明度 (0 ~ 255)，
+//           由下往上逐列、每列由左往右；線段為空或發生錯誤時沒有透明度資料，
+//           沒有反鋸齒的演算法只回傳實際被畫到的範圍
+namespace Server
+{
+    constexpr uint32_t REQUEST_MAGIC = 0x51524c52;  // "RLRQ"
+    constexpr uint32_t RESPONSE_MAGIC = 0x53524c52; // "RLRS"
+
+    // 單一 request 的線段數上限
+    constexpr uint32_t MAX_SEGMENTS = 65536;
+    // 座標絕對值上限，限制回傳 buffer 的大小
+    constexpr int32_t MAX_COORDINATE = 2048;
+
+    // 由 server 依每個 request 的線段自動選擇演算法
+    constexpr uint32_t ALGORITHM_AUTO = 0xfffffffe;
+    constexpr uint32_t ALGORITHM_AUTO_ANTI_ALIASING = 0xffffffff;
+
+    enum Status : uint32_t
+    {
+        STATUS_OK = 0,
+        STATUS_UNKNOWN_ALGORITHM = 1,
+        STATUS_OUT_OF_RANGE = 2,
+        // 有此演算法，但 server 的 CPU 不支援
+        STATUS_UNSUPPORTED_ALGORITHM = 3
+    };
+
+    struct RequestHeader
+    {
+        uint32_t magic;
+        // 演算法編號，與 Registry 的註冊順序相同，或是 ALGORITHM_AUTO / ALGORITHM_AUTO_ANTI_ALIASING
+        uint32_t algorithm;
+        uint32_t segmentCount;
+    };
+
+    struct ResponseHeader
+    {
+        uint32_t magic;
+        uint32_t status;
+        int32_t left;
+        int32_t bottom;
+        int32_t right;
+        int32_t top;
+        // 被畫到 (透明度大於 0) 的格子數
+        uint32_t drawnCount;
+    };
+
+    class RenderServer
+    {
+    public:
+        explicit RenderServer(const std::string& socketPath, const Algorithms::Registry& registry, unsigned int threadCount);
+        ~RenderServer();
+
+        RenderServer(const RenderServer&) = delete;
+        RenderServer& operator=(const RenderServer&) = delete;
+
+        /// <summary>
+        /// 開始接受連線並處理 request，發生錯誤時丟出 std::runtime_error
+        /// </summary>
+        void run();
+    private:
+        struct Job
+        {
+            unsigned long long connectionId;
+            uint32_t algorithm;
+            std::vector<Rendering::Segment> segments;
+            std::vector<uint8_t> response;
+        };
+
+        // 每個 worker thread 重複使用的光柵化 buffer
+        struct WorkerState
+        {
+            Rendering::Rect bounds;
+            // 反鋸齒演算法使用
+            std::vector<float> coverage;
+            // 沒有反鋸齒的演算法使用
+            Rendering::BitBuffer bits;
+            bool isAliased;
+        };
+
+        struct Connection
+        {
+            int socket;
+            std::vector<uint8_t> input;
+            std::vector<uint8_t> output;
+            // 一個連線同時只處理一個 request，回應才會依序送出
+            bool isBusy;
+            // 對方已關閉寫入，回應都送出後就關閉連線
+            bool isReadClosed;
+        };
+
+        // worker thread 主迴圈，每次上鎖可取走多個 request，不會把它們合併成一次光柵化
+        void work();
+        // 光柵化一個 request 並寫入回應
+        void render(Job& job, const std::vector<std::unique_ptr<Algorithms::Algorithm>>& algorithms, WorkerState& state) const;
+        // 將完成的工作交回 poll 迴圈
+        void completeJob(std::unique_ptr<Job> job);
+
+        void acceptConnections();
+        void readConnection(unsigned long long id);
+        void writeConnection(unsigned long long id);
+        void closeConnection(unsigned long long id);
+        // 對方已關閉寫入、沒有處理中的 request 且回應都已送出時關閉連線
+        void closeIfFinished(unsigned long long id);
+        // 將完整收到的 request 交給 worker thread，協定錯誤時回傳 false
+        bool dispatchRequests(Connection& connection, unsigned long long id);
+        // 將完成的回應放入連線的輸出
+        void collectResponses();
+
+        const std::string _socketPath;
+        const Algorithms::Registry _registry;
+        const unsigned int _threadCount;
+
+        int _listenSocket;
+        // socket 檔是否由此 process 建立，結束時才需要移除
+        bool _isSocketBound;
+        // worker thread 完成工作時寫入，喚醒 poll
+        int _wakePipe[2];
+
+        std::map<unsigned long long, Connection> _connections;
+        unsigned long long _nextConnectionId;
+
+        std::mutex _jobMutex;
+        std::condition_variable _jobCondition;
+        std::deque<std::unique_ptr<Job>> _pendingJobs;
+        bool _isStopping;
+
+        std::mutex _completedMutex;
+        std::vector<std::unique_ptr<Job>> _completedJobs;
+
+        std::vector<std::thread> _workers;
+    };
+
+    class RenderClient
+    {
+    public:
+        explicit RenderClient(const std::string& socketPath);
+        ~RenderClient();
+
+        RenderClient(const RenderClient&) = delete;
+        RenderClient& operator=(const RenderClient&) = delete;
+
+        /// <summary>
+        /// 送出線段並等待光柵化結果，發生錯誤時丟出 std::runtime_error
+        /// </summary>
+        /// <param name="algorithm"></param>
+        /// <param name="segments"></param>
+        /// <param name="coverage">每個格子的透明度</param>
+        /// <returns></returns>
+        ResponseHeader render(uint32_t algorithm, const std::vector<Rendering::Segment>& segments, std::vector<uint8_t>& coverage);
+    private:
+        int _socket;
+    };
+}